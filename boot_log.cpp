@@ -0,0 +1,73 @@
+/*
+ * micro32/boot_log.cpp
+ *
+ * Boot-stage timestamp log. See boot_log.h.
+ *
+ * Notes:
+ *  - boot_log_cycles[] is defined in startup.s on target so the reset path
+ *    can store into it before the C++ runtime exists. Host builds, which
+ *    have no startup.s, define it here and have no assembly stages.
+ *  - Stage names live in normal BSS: they are only needed for the entries
+ *    written after BSS has been cleared.
+ *  - An assembly slot still holding 0 was not reached (or this is a host
+ *    build) and is skipped.
+ */
+
+#include "boot_log.h"
+#include "text_format.h"
+#include "timer.h"
+#include <cstdint>
+
+extern "C" uint64_t boot_log_cycles[BootLog::MAX_ENTRIES];
+#ifdef MICRO32_HOST
+uint64_t boot_log_cycles[BootLog::MAX_ENTRIES];
+#endif
+
+namespace BootLog {
+
+static const char* const ASM_STAGE_NAMES[ASM_STAGES] = {"reset", "stack", "bss"};
+
+static const char* s_names[MAX_ENTRIES];
+static int s_count = ASM_STAGES;
+
+void mark(const char* name) {
+    if (s_count >= MAX_ENTRIES) return;
+    boot_log_cycles[s_count] = Timer::cycles();
+    s_names[s_count] = name;
+    s_count++;
+}
+
+int entries(Entry* out, int max) {
+    int n = 0;
+    for (int i = 0; i < s_count; i++) {
+        if (i < ASM_STAGES && boot_log_cycles[i] == 0) continue;
+        if (n < max) {
+            out[n].name = i < ASM_STAGES ? ASM_STAGE_NAMES[i] : s_names[i];
+            out[n].cycles = boot_log_cycles[i];
+        }
+        n++;
+    }
+    return n;
+}
+
+void dump(LineSink sink) {
+    Entry log[MAX_ENTRIES];
+    int count = entries(log, MAX_ENTRIES);
+    if (count > MAX_ENTRIES) count = MAX_ENTRIES;
+
+    TextFormat::Line line;
+    uint64_t prev = 0;
+    for (int i = 0; i < count; i++) {
+        line.clear();
+        line.add(log[i].name);
+        line.add(" +");
+        line.add(Timer::cycles_to_us(log[i].cycles - prev));
+        line.add("us @");
+        line.add(Timer::cycles_to_us(log[i].cycles));
+        line.add("us");
+        sink(line.text);
+        prev = log[i].cycles;
+    }
+}
+
+} // namespace BootLog
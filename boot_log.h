@@ -0,0 +1,46 @@
+#ifndef MICRO32_BOOT_LOG_H
+#define MICRO32_BOOT_LOG_H
+
+// boot_log.h
+// Boot-stage timestamps from Reset_Handler to the first pixels.
+//
+// The log is a fixed array of 64-bit mcycle values, boot_log_cycles[], in
+// the .noinit section so clearing BSS does not wipe the stamps taken before
+// it. The first ASM_STAGES slots are written by startup.s before any C++
+// runs (reset entry, stack ready, BSS cleared); kernel code appends named
+// stages with mark(). mcycle counts from reset, so every entry is an
+// absolute time since power-on and differences give stage durations.
+//
+// dump() turns the log into one line per stage ("name +delta us @time us")
+// for the LCD or a serial log.
+
+#include <cstdint>
+
+namespace BootLog {
+
+constexpr int MAX_ENTRIES = 16;
+
+// Slots filled by startup.s (must match the BOOT_STAMP slots there)
+constexpr int ASM_STAGES = 3;
+
+struct Entry {
+    const char* name;
+    uint64_t cycles;   // mcycle when the stage was reached
+};
+
+// Record that the stage `name` was reached now. `name` must stay valid
+// (use a string literal). Ignored once the log is full.
+void mark(const char* name);
+
+// Fill `out` with up to `max` recorded entries in order; returns how many
+// there are
+int entries(Entry* out, int max);
+
+using LineSink = void (*)(const char* line);
+
+// Write one line per stage to `sink`
+void dump(LineSink sink);
+
+} // namespace BootLog
+
+#endif // MICRO32_BOOT_LOG_H
@@ -0,0 +1,76 @@
+/*
+ * micro32/cache.cpp
+ *
+ * Zicbom cache maintenance. See cache.h.
+ *
+ * Notes:
+ *  - Each operation walks whole lines from the line containing `addr` to
+ *    the one containing the last byte, then fences so the DMA engine (or a
+ *    following CPU load) sees the result.
+ *  - Builds without Zicbom (and host builds) compile the walks out; only
+ *    the fence remains.
+ */
+
+#include "cache.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace Cache {
+
+enum class Op : uint8_t {
+    Clean,   // cbo.clean: write back
+    Flush,   // cbo.flush: write back and invalidate
+    Inval,   // cbo.inval: invalidate
+};
+
+static void for_each_line(const void* addr, std::size_t bytes, Op op) {
+#if defined(__riscv_zicbom) && !defined(MICRO32_HOST)
+    if (bytes == 0) return;
+    uintptr_t line = reinterpret_cast<uintptr_t>(addr) & ~(uintptr_t)(LINE_SIZE - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + bytes;
+    for (; line < end; line += LINE_SIZE) {
+        switch (op) {
+        case Op::Clean:
+            asm volatile("cbo.clean (%0)" : : "r"(line) : "memory");
+            break;
+        case Op::Flush:
+            asm volatile("cbo.flush (%0)" : : "r"(line) : "memory");
+            break;
+        case Op::Inval:
+            asm volatile("cbo.inval (%0)" : : "r"(line) : "memory");
+            break;
+        }
+    }
+#else
+    (void)addr;
+    (void)bytes;
+    (void)op;
+#endif
+    __sync_synchronize();
+}
+
+void writeback(const void* addr, std::size_t bytes) {
+    for_each_line(addr, bytes, Op::Clean);
+}
+
+void invalidate(const void* addr, std::size_t bytes) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t end = start + bytes;
+    uintptr_t inner_start = (start + LINE_SIZE - 1) & ~(uintptr_t)(LINE_SIZE - 1);
+    uintptr_t inner_end = end & ~(uintptr_t)(LINE_SIZE - 1);
+
+    if (inner_start >= inner_end) {
+        for_each_line(addr, bytes, Op::Flush);
+        return;
+    }
+    // Lines shared with data outside the range must not lose it
+    if (start != inner_start) for_each_line(addr, inner_start - start, Op::Flush);
+    if (end != inner_end) for_each_line(reinterpret_cast<const void*>(inner_end), end - inner_end, Op::Flush);
+    for_each_line(reinterpret_cast<const void*>(inner_start), inner_end - inner_start, Op::Inval);
+}
+
+void writeback_invalidate(const void* addr, std::size_t bytes) {
+    for_each_line(addr, bytes, Op::Flush);
+}
+
+} // namespace Cache
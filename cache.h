@@ -0,0 +1,54 @@
+#ifndef MICRO32_CACHE_H
+#define MICRO32_CACHE_H
+
+// cache.h
+// Data cache maintenance for memory shared with DMA engines.
+//
+// The ESP32-P4 PSRAM window is cached and DMA engines do not snoop the
+// cache, so software must keep them coherent:
+//  - before a DMA engine reads CPU-written memory, writeback() it;
+//  - before a DMA engine writes memory the CPU may have cached,
+//    writeback_invalidate() it (so no dirty line lands on the result),
+//    and invalidate() it again before the CPU reads the result.
+//
+// The operations use the Zicbom instructions (cbo.clean / cbo.flush /
+// cbo.inval) one cache line at a time and are only compiled in when the
+// toolchain targets Zicbom. Without them available() is false and callers
+// must keep DMA buffers out of cached memory (MemoryMap placements that
+// exclude ATTR_CACHED) instead. Host builds are coherent: the operations
+// are no-ops and available() is true.
+
+#include <cstdint>
+#include <cstddef>
+
+// Data cache line size; must match the core (64 bytes on the ESP32-P4)
+#ifndef MICRO32_CBO_BLOCK
+#define MICRO32_CBO_BLOCK 64
+#endif
+
+namespace Cache {
+
+constexpr std::size_t LINE_SIZE = MICRO32_CBO_BLOCK;
+
+// True if this build can keep cached memory coherent with DMA
+constexpr bool available() {
+#if defined(MICRO32_HOST) || defined(__riscv_zicbom)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Write dirty lines covering [addr, addr + bytes) back to memory
+void writeback(const void* addr, std::size_t bytes);
+
+// Drop lines covering the range without writing them back. Partial lines
+// at either end are written back first so neighbouring data survives.
+void invalidate(const void* addr, std::size_t bytes);
+
+// Write back, then drop, every line covering the range
+void writeback_invalidate(const void* addr, std::size_t bytes);
+
+} // namespace Cache
+
+#endif // MICRO32_CACHE_H
@@ -0,0 +1,137 @@
+
+
+#include <cstdint>
+#include "console.h"
+#include "lcd.h"
+
+namespace Console {
+
+    constexpr int COLS = LCDDriver::LCD_WIDTH / LCDDriver::GLYPH_WIDTH;
+    constexpr int ROWS = LCDDriver::LCD_HEIGHT / LCDDriver::GLYPH_HEIGHT;
+    constexpr int TAB_SIZE = 4;
+
+    static uint16_t s_fg = 0xFFFF;
+    static uint16_t s_bg = 0x0000;
+    static int s_col = 0;
+    static int s_row = 0;
+
+    // Text row currently shown at the top of the panel (hardware scroll offset)
+    static int s_top = 0;
+
+    // Panel y coordinate of a logical console row
+    static int rowToY(int row) {
+        return ((s_top + row) % ROWS) * LCDDriver::GLYPH_HEIGHT;
+    }
+
+    // Scroll one text row: the old top row becomes the new bottom row, which
+    // is cleared. Costs one line fill plus one VSCRSADD command.
+    static void scrollUp() {
+        s_top = (s_top + 1) % ROWS;
+        LCDDriver::fillRect(0, rowToY(ROWS - 1), LCDDriver::LCD_WIDTH, LCDDriver::GLYPH_HEIGHT, s_bg);
+
+        // The cleared line has to reach the panel before it scrolls into view
+        if (LCDDriver::framebufferEnabled()) LCDDriver::flush();
+        LCDDriver::setScrollStart(s_top * LCDDriver::GLYPH_HEIGHT);
+    }
+
+    static void newLine() {
+        s_col = 0;
+        if (s_row + 1 < ROWS) {
+            s_row++;
+        } else {
+            scrollUp();
+        }
+    }
+
+    void init(uint16_t fg, uint16_t bg) {
+        s_fg = fg;
+        s_bg = bg;
+        s_col = 0;
+        s_row = 0;
+        s_top = 0;
+
+        LCDDriver::clearScreen(bg);
+        if (LCDDriver::framebufferEnabled()) LCDDriver::flush();
+        LCDDriver::setScrollArea(0, 0);
+        LCDDriver::setScrollStart(0);
+    }
+
+    void setColors(uint16_t fg, uint16_t bg) {
+        s_fg = fg;
+        s_bg = bg;
+    }
+
+    void setCursor(int col, int row) {
+        s_col = col < 0 ? 0 : (col >= COLS ? COLS - 1 : col);
+        s_row = row < 0 ? 0 : (row >= ROWS ? ROWS - 1 : row);
+    }
+
+    // Draw `len` printable characters at the cursor (must fit on the row)
+    static void emit(const char* text, int len) {
+        char run[COLS + 1];
+        for (int i = 0; i < len; i++) {
+            run[i] = text[i];
+        }
+        run[len] = '\0';
+
+        LCDDriver::Print(run, s_col * LCDDriver::GLYPH_WIDTH, rowToY(s_row), s_fg, s_bg);
+        s_col += len;
+    }
+
+    // Control characters; returns false for anything that should be printed
+    static bool control(char c) {
+        switch (c) {
+            case '\n':
+                newLine();
+                return true;
+            case '\r':
+                s_col = 0;
+                return true;
+            case '\t': {
+                if (s_col >= COLS) newLine();
+                int spaces = TAB_SIZE - (s_col % TAB_SIZE);
+                for (int i = 0; i < spaces && s_col < COLS; i++) {
+                    emit(" ", 1);
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    void putChar(char c) {
+        if (control(c)) return;
+        if (s_col >= COLS) newLine();  // Deferred wrap
+        emit(&c, 1);
+    }
+
+    void write(const char* str) {
+        while (*str) {
+            if (control(*str)) {
+                str++;
+                continue;
+            }
+
+            if (s_col >= COLS) newLine();  // Deferred wrap
+
+            // Longest printable run that fits on the current row
+            int len = 0;
+            int room = COLS - s_col;
+            while (len < room && str[len] && str[len] != '\n' && str[len] != '\r' && str[len] != '\t') {
+                len++;
+            }
+
+            emit(str, len);
+            str += len;
+        }
+    }
+
+    int cols() {
+        return COLS;
+    }
+
+    int rows() {
+        return ROWS;
+    }
+}
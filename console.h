@@ -0,0 +1,33 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <cstdint>
+
+// Terminal-style text console on top of LCDDriver.
+// Text flows left to right and wraps when the next character would not fit
+// on the row, so a full row followed by '\n' does not leave a blank line.
+// Once the cursor passes the last row the console scrolls with the
+// controller's hardware vertical scroll (VSCRSADD) and only the newly
+// exposed line is cleared and redrawn.
+namespace Console {
+    // Clear the screen, reset the hardware scroll and home the cursor
+    void init(uint16_t fg = 0xFFFF, uint16_t bg = 0x0000);
+
+    // Colors used for subsequent output
+    void setColors(uint16_t fg, uint16_t bg);
+
+    // Move the cursor to a text cell (clamped to the console size)
+    void setCursor(int col, int row);
+
+    // Write one character; handles '\n', '\r' and '\t'
+    void putChar(char c);
+
+    // Write a null-terminated string; printable runs go out as one Print each
+    void write(const char* str);
+
+    // Console size in text cells
+    int cols();
+    int rows();
+}
+
+#endif // CONSOLE_H
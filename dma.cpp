@@ -0,0 +1,224 @@
+/*
+ * micro32/dma.cpp
+ *
+ * Asynchronous DMA transfer engine for the LCD SPI transmitter.
+ *
+ * Behavior:
+ *  - Transfers are kept in a small ring (MAX_PENDING entries). The entry at
+ *    the head is the one on the wire; completion retires it, runs its
+ *    callback and starts the next entry.
+ *  - Handles are sequence numbers, so is_done() is a single comparison
+ *    against the sequence number of the last retired transfer.
+ *
+ * Notes:
+ *  - The register map below is a placeholder modelled on the ESP32 GDMA
+ *    "out" channel; replace the addresses with the actual ones.
+ *  - Buffers must be written back from the data cache before submit() if
+ *    they live in cached memory; the engine only issues a memory fence.
+ */
+
+#include "dma.h"
+#include "mmio.h"
+#include <cstdint>
+#include <cstddef>
+
+// Define memory-mapped registers for the DMA "out" channel
+#define DMA_BASE 0x60080000              // Replace with the actual DMA base address
+#define DMA_OUT_LINK_ADDR_REG (DMA_BASE + 0x00)  // address of first descriptor
+#define DMA_OUT_LINK_CTRL_REG (DMA_BASE + 0x04)  // bit 0: start, bit 1: stop
+#define DMA_INT_RAW_REG (DMA_BASE + 0x08)        // bit 0: out_eof (chain done)
+#define DMA_INT_CLR_REG (DMA_BASE + 0x0C)        // write 1 to clear
+#define DMA_OUT_CONF_REG (DMA_BASE + 0x10)       // bit 0: reset channel
+
+namespace Dma {
+
+// Descriptor config word fields
+constexpr uint32_t DESC_SIZE_MASK = 0xFFFu;
+constexpr uint32_t DESC_LENGTH_SHIFT = 12;
+constexpr uint32_t DESC_EOF = 1u << 30;
+constexpr uint32_t DESC_OWNER_DMA = 1u << 31;
+
+// Queue of transfers; s_queue[s_head] is in flight when s_in_flight is set
+static Transfer s_queue[MAX_PENDING];
+static int s_head = 0;
+static int s_count = 0;
+static bool s_in_flight = false;
+
+static Handle s_next_handle = 1;     // handle of the next submitted transfer
+static Handle s_retired_handle = 0;  // handle of the last completed transfer
+
+#ifndef MICRO32_HOST
+
+// --- Hardware backend ---
+
+static void hw_reset() {
+    Mmio::write32(DMA_OUT_CONF_REG, 1);  // Reset the channel
+    Mmio::write32(DMA_OUT_CONF_REG, 0);
+    Mmio::write32(DMA_INT_CLR_REG, 1);
+}
+
+static void hw_start(Descriptor* chain) {
+    // Make descriptor and buffer writes visible before the engine reads them
+    __sync_synchronize();
+    Mmio::write32(DMA_OUT_LINK_ADDR_REG, reinterpret_cast<uintptr_t>(chain));
+    Mmio::write32(DMA_OUT_LINK_CTRL_REG, 1);  // Start
+}
+
+static bool hw_done() {
+    return (Mmio::read32(DMA_INT_RAW_REG) & (1 << 0)) != 0;
+}
+
+static void hw_ack() {
+    Mmio::write32(DMA_INT_CLR_REG, 1);
+}
+
+// Called while spinning on a transfer
+static void hw_idle_hint() {
+}
+
+#else
+
+// --- Host mock backend ---
+
+static Descriptor* s_mock_chain = nullptr;
+static bool s_mock_done = false;
+static bool s_mock_auto = false;
+static std::size_t s_mock_bytes = 0;
+static void (*s_mock_sink)(const void*, std::size_t) = nullptr;
+
+static void hw_reset() {
+    s_mock_chain = nullptr;
+    s_mock_done = false;
+    s_mock_bytes = 0;
+}
+
+static void hw_start(Descriptor* chain) {
+    s_mock_chain = chain;
+    s_mock_done = false;
+    if (s_mock_auto) Mock::complete_current();
+}
+
+static bool hw_done() {
+    return s_mock_done;
+}
+
+static void hw_ack() {
+    s_mock_done = false;
+}
+
+// Spinning on host means "let the wire time pass"
+static void hw_idle_hint() {
+    Mock::complete_current();
+}
+
+bool Mock::complete_current() {
+    if (s_mock_chain == nullptr) return false;
+
+    for (Descriptor* d = s_mock_chain; d != nullptr; d = d->next) {
+        std::size_t length = (d->config >> DESC_LENGTH_SHIFT) & DESC_SIZE_MASK;
+        if (s_mock_sink) s_mock_sink(d->buffer, length);
+        s_mock_bytes += length;
+        Mmio::Host::add_wire_bytes(length);
+        d->config &= ~DESC_OWNER_DMA;  // Hand the descriptor back to the CPU
+        if (d->config & DESC_EOF) break;
+    }
+
+    s_mock_chain = nullptr;
+    s_mock_done = true;
+    return true;
+}
+
+void Mock::set_auto_complete(bool enabled) {
+    s_mock_auto = enabled;
+}
+
+void Mock::set_sink(void (*sink)(const void* data, std::size_t length)) {
+    s_mock_sink = sink;
+}
+
+std::size_t Mock::bytes_transferred() {
+    return s_mock_bytes;
+}
+
+#endif
+
+void make_descriptor(Descriptor& desc, const void* buffer, std::size_t length,
+                     Descriptor* next, bool eof) {
+    uint32_t len = static_cast<uint32_t>(length) & DESC_SIZE_MASK;
+    uint32_t config = len | (len << DESC_LENGTH_SHIFT) | DESC_OWNER_DMA;
+    if (eof) config |= DESC_EOF;
+
+    desc.config = config;
+    desc.buffer = buffer;
+    desc.next = eof ? nullptr : next;
+}
+
+// Hand the transfer at the head of the queue to the hardware
+static void start_head() {
+    Transfer& t = s_queue[s_head];
+    if (t.on_start) t.on_start(t.context);
+    s_in_flight = true;
+    hw_start(t.chain);
+}
+
+void init() {
+    hw_reset();
+    s_head = 0;
+    s_count = 0;
+    s_in_flight = false;
+    s_retired_handle = s_next_handle - 1;
+}
+
+void service() {
+    if (s_in_flight && hw_done()) {
+        hw_ack();
+        Transfer done = s_queue[s_head];
+        s_head = (s_head + 1) % MAX_PENDING;
+        s_count--;
+        s_in_flight = false;
+        s_retired_handle++;
+
+        if (done.on_complete) done.on_complete(done.context);
+    }
+
+    if (!s_in_flight && s_count > 0) {
+        start_head();
+    }
+}
+
+Handle submit(const Transfer& transfer) {
+    // Make room if the queue is full
+    while (s_count == MAX_PENDING) {
+        service();
+        if (s_count == MAX_PENDING) hw_idle_hint();
+    }
+
+    int tail = (s_head + s_count) % MAX_PENDING;
+    s_queue[tail] = transfer;
+    s_count++;
+
+    Handle handle = s_next_handle++;
+    if (!s_in_flight) service();
+    return handle;
+}
+
+bool is_done(Handle handle) {
+    return handle <= s_retired_handle;
+}
+
+void wait(Handle handle) {
+    while (!is_done(handle)) {
+        service();
+        if (!is_done(handle)) hw_idle_hint();
+    }
+}
+
+void wait_all() {
+    wait(s_next_handle - 1);
+}
+
+bool busy() {
+    return s_count > 0;
+}
+
+} // namespace Dma
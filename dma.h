@@ -0,0 +1,106 @@
+#ifndef MICRO32_DMA_H
+#define MICRO32_DMA_H
+
+// dma.h
+// Asynchronous DMA transfer engine feeding the LCD SPI transmitter.
+//
+// A transfer is a chain of linked descriptors, each pointing at a buffer in
+// RAM (typically one framebuffer row). Transfers are queued with submit() and
+// go out on the wire strictly in submission order; the CPU is free while a
+// chain is being transmitted.
+//
+//  - submit() queues a transfer and returns a handle. If the hardware is idle
+//    the transfer starts immediately; otherwise it starts when the previous
+//    one completes.
+//  - service() retires a finished transfer (running its completion callback)
+//    and starts the next one. It is called from wait()/submit() and may be
+//    called from a polling loop or the DMA interrupt.
+//  - wait() blocks until a given transfer (and all before it) has completed.
+//
+// Each transfer may carry an `on_start` hook that runs right before the chain
+// is handed to the hardware. The LCD driver uses it to program the address
+// window for that chain, so several rectangles can be queued back to back.
+//
+// Host builds (MICRO32_HOST defined) replace the register accesses with a
+// software model of the controller; see the Mock namespace below.
+//
+// Reentrancy: service() must not run concurrently with itself.
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Dma {
+
+// Hardware linked-list descriptor (GDMA layout, 12 bytes, word aligned)
+struct Descriptor {
+    volatile uint32_t config;   // [11:0] size, [23:12] length, [30] eof, [31] owner
+    const void* buffer;         // source buffer
+    Descriptor* next;           // next descriptor or nullptr
+};
+
+// Largest byte count a single descriptor can carry (kept word-aligned)
+constexpr std::size_t MAX_DESCRIPTOR_BYTES = 4092;
+
+// Maximum number of transfers queued (including the one in flight)
+constexpr int MAX_PENDING = 8;
+
+using Callback = void (*)(void* context);
+
+// Transfer handle. Handles are increasing sequence numbers; 0 is never valid.
+using Handle = uint32_t;
+
+struct Transfer {
+    Descriptor* chain;     // first descriptor of the chain
+    Callback on_start;     // optional: runs just before the hardware starts
+    Callback on_complete;  // optional: runs from service() once transmitted
+    void* context;         // passed to both callbacks
+};
+
+// Fill in one descriptor. `eof` marks the last descriptor of a chain.
+void make_descriptor(Descriptor& desc, const void* buffer, std::size_t length,
+                     Descriptor* next, bool eof);
+
+// Reset the controller and drop any queued transfers
+void init();
+
+// Queue a transfer. Blocks only if MAX_PENDING transfers are already queued.
+Handle submit(const Transfer& transfer);
+
+// Retire the finished transfer (if any) and start the next queued one
+void service();
+
+// True once the transfer identified by `handle` has completed
+bool is_done(Handle handle);
+
+// Block until the transfer identified by `handle` has completed
+void wait(Handle handle);
+
+// Block until every queued transfer has completed
+void wait_all();
+
+// True while any transfer is queued or in flight
+bool busy();
+
+#ifdef MICRO32_HOST
+// Software model of the DMA controller used on host builds.
+// By default a transfer stays "on the wire" until complete_current() is
+// called, which lets tests observe queueing and ordering; wait() completes
+// the current transfer itself so it never deadlocks.
+namespace Mock {
+    // Finish the transfer currently in flight. Returns false if idle.
+    bool complete_current();
+
+    // Complete every transfer as soon as it starts
+    void set_auto_complete(bool enabled);
+
+    // Receives every descriptor buffer in wire order
+    void set_sink(void (*sink)(const void* data, std::size_t length));
+
+    // Total bytes the model has transmitted since init()
+    std::size_t bytes_transferred();
+}
+#endif
+
+} // namespace Dma
+
+#endif // MICRO32_DMA_H
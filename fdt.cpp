@@ -0,0 +1,224 @@
+/*
+ * micro32/fdt.cpp
+ *
+ * Allocation-free device tree walk for the boot memory map. See fdt.h.
+ *
+ * Notes:
+ *  - DTB fields are big-endian; everything is read byte by byte, so the
+ *    blob needs no particular alignment on the host.
+ *  - Depth counts the root node as 1, so memory nodes are at depth 2 and
+ *    reserved-memory children at depth 3.
+ *  - Properties always precede subnodes in a DTB, so cell sizes are known
+ *    before any `reg` below them is decoded. Within a node, `reg` may come
+ *    before `device_type`, so nodes are classified when they end.
+ */
+
+#include "fdt.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace Fdt {
+
+// Structure block tokens
+constexpr uint32_t FDT_BEGIN_NODE = 1;
+constexpr uint32_t FDT_END_NODE = 2;
+constexpr uint32_t FDT_PROP = 3;
+constexpr uint32_t FDT_NOP = 4;
+constexpr uint32_t FDT_END = 9;
+
+// Header field offsets
+constexpr uint32_t HDR_MAGIC = 0;
+constexpr uint32_t HDR_TOTALSIZE = 4;
+constexpr uint32_t HDR_OFF_STRUCT = 8;
+constexpr uint32_t HDR_OFF_STRINGS = 12;
+constexpr uint32_t HDR_OFF_RSVMAP = 16;
+constexpr uint32_t HDR_VERSION = 20;
+constexpr uint32_t HDR_SIZE_STRINGS = 32;
+constexpr uint32_t HDR_SIZE_STRUCT = 36;
+constexpr uint32_t HDR_SIZE = 40;
+
+static inline uint32_t be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+static inline uint64_t be64(const uint8_t* p) {
+    return (uint64_t(be32(p)) << 32) | be32(p + 4);
+}
+
+static inline uint32_t align4(uint32_t v) {
+    return (v + 3) & ~3u;
+}
+
+bool valid(const void* blob) {
+    if (blob == nullptr) return false;
+    const uint8_t* b = static_cast<const uint8_t*>(blob);
+    if (be32(b + HDR_MAGIC) != MAGIC) return false;
+
+    uint32_t total = be32(b + HDR_TOTALSIZE);
+    if (total < HDR_SIZE || be32(b + HDR_VERSION) < 17) return false;
+
+    uint32_t off_struct = be32(b + HDR_OFF_STRUCT);
+    uint32_t off_strings = be32(b + HDR_OFF_STRINGS);
+    uint32_t size_struct = be32(b + HDR_SIZE_STRUCT);
+    uint32_t size_strings = be32(b + HDR_SIZE_STRINGS);
+    if (off_struct > total || size_struct > total - off_struct) return false;
+    if (off_strings > total || size_strings > total - off_strings) return false;
+
+    // Property names are looked up with str* functions; keep them in bounds
+    if (size_strings > 0 && b[off_strings + size_strings - 1] != '\0') return false;
+    return be32(b + HDR_OFF_RSVMAP) < total;
+}
+
+uint32_t total_size(const void* blob) {
+    return valid(blob) ? be32(static_cast<const uint8_t*>(blob) + HDR_TOTALSIZE) : 0;
+}
+
+static void add_range(Range* ranges, int& count, int max, bool& truncated,
+                      uint64_t base, uint64_t size) {
+    if (size == 0) return;
+    if (count >= max) {
+        truncated = true;
+        return;
+    }
+    ranges[count].base = base;
+    ranges[count].size = size;
+    count++;
+}
+
+// Decode a `reg` property into (base, size) pairs
+static bool decode_reg(const uint8_t* reg, uint32_t len, uint32_t addr_cells, uint32_t size_cells,
+                       Range* ranges, int& count, int max, bool& truncated) {
+    if (addr_cells < 1 || addr_cells > 2 || size_cells > 2) return false;
+    uint32_t entry = 4 * (addr_cells + size_cells);
+
+    for (uint32_t off = 0; off + entry <= len; off += entry) {
+        const uint8_t* p = reg + off;
+        uint64_t base = addr_cells == 2 ? be64(p) : be32(p);
+        p += 4 * addr_cells;
+        uint64_t size = size_cells == 2 ? be64(p) : (size_cells == 1 ? be32(p) : 0);
+        add_range(ranges, count, max, truncated, base, size);
+    }
+    return true;
+}
+
+// Top-level node names we care about ("memory" or "memory@<addr>")
+static bool is_memory_name(const char* name) {
+    return strncmp(name, "memory", 6) == 0 && (name[6] == '\0' || name[6] == '@');
+}
+
+bool parse_memory(const void* blob, MemoryInfo& out) {
+    out.memory_count = 0;
+    out.reserved_count = 0;
+    out.truncated = false;
+    if (!valid(blob)) return false;
+
+    const uint8_t* b = static_cast<const uint8_t*>(blob);
+    uint32_t total = be32(b + HDR_TOTALSIZE);
+    const char* strings = reinterpret_cast<const char*>(b + be32(b + HDR_OFF_STRINGS));
+    uint32_t size_strings = be32(b + HDR_SIZE_STRINGS);
+
+    // Memory reservation block: (address, size) pairs ending with (0, 0)
+    for (uint32_t off = be32(b + HDR_OFF_RSVMAP); off + 16 <= total; off += 16) {
+        uint64_t base = be64(b + off);
+        uint64_t size = be64(b + off + 8);
+        if (base == 0 && size == 0) break;
+        add_range(out.reserved, out.reserved_count, MAX_RESERVED_RANGES, out.truncated, base, size);
+    }
+
+    uint32_t pos = be32(b + HDR_OFF_STRUCT);
+    uint32_t end = pos + be32(b + HDR_SIZE_STRUCT);
+
+    int depth = 0;
+    uint32_t root_addr_cells = 2, root_size_cells = 1;
+    uint32_t rsv_addr_cells = 2, rsv_size_cells = 1;
+
+    // State of the current top-level node (depth 2) and its child (depth 3)
+    bool node_memory = false;
+    bool node_reserved = false;
+    const uint8_t* node_reg = nullptr;
+    uint32_t node_reg_len = 0;
+    const uint8_t* child_reg = nullptr;
+    uint32_t child_reg_len = 0;
+
+    while (pos + 4 <= end) {
+        uint32_t token = be32(b + pos);
+        pos += 4;
+
+        if (token == FDT_BEGIN_NODE) {
+            const char* name = reinterpret_cast<const char*>(b + pos);
+            uint32_t len = 0;
+            while (pos + len < end && name[len] != '\0') len++;
+            if (pos + len >= end) return false;
+            pos += align4(len + 1);
+            depth++;
+
+            if (depth == 2) {
+                node_memory = is_memory_name(name);
+                node_reserved = strcmp(name, "reserved-memory") == 0;
+                node_reg = nullptr;
+                node_reg_len = 0;
+                rsv_addr_cells = root_addr_cells;
+                rsv_size_cells = root_size_cells;
+            } else if (depth == 3) {
+                child_reg = nullptr;
+                child_reg_len = 0;
+            }
+        } else if (token == FDT_END_NODE) {
+            if (depth == 2 && node_memory && node_reg != nullptr) {
+                if (!decode_reg(node_reg, node_reg_len, root_addr_cells, root_size_cells,
+                                out.memory, out.memory_count, MAX_MEMORY_RANGES, out.truncated)) {
+                    return false;
+                }
+            } else if (depth == 3 && node_reserved && child_reg != nullptr) {
+                if (!decode_reg(child_reg, child_reg_len, rsv_addr_cells, rsv_size_cells,
+                                out.reserved, out.reserved_count, MAX_RESERVED_RANGES, out.truncated)) {
+                    return false;
+                }
+            }
+            if (depth == 0) return false;
+            depth--;
+        } else if (token == FDT_PROP) {
+            if (pos + 8 > end) return false;
+            uint32_t len = be32(b + pos);
+            uint32_t name_off = be32(b + pos + 4);
+            pos += 8;
+            if (len > end - pos || name_off >= size_strings) return false;
+
+            const char* name = strings + name_off;
+            const uint8_t* data = b + pos;
+            pos += align4(len);
+
+            bool is_cells = len == 4 && (strcmp(name, "#address-cells") == 0 ||
+                                         strcmp(name, "#size-cells") == 0);
+            bool is_address = name[1] == 'a';
+
+            if (depth == 1 && is_cells) {
+                (is_address ? root_addr_cells : root_size_cells) = be32(data);
+            } else if (depth == 2) {
+                if (strcmp(name, "reg") == 0) {
+                    node_reg = data;
+                    node_reg_len = len;
+                } else if (strcmp(name, "device_type") == 0 && len == 7 &&
+                           memcmp(data, "memory", 7) == 0) {
+                    node_memory = true;
+                } else if (node_reserved && is_cells) {
+                    (is_address ? rsv_addr_cells : rsv_size_cells) = be32(data);
+                }
+            } else if (depth == 3 && node_reserved && strcmp(name, "reg") == 0) {
+                child_reg = data;
+                child_reg_len = len;
+            }
+        } else if (token == FDT_NOP) {
+            continue;
+        } else if (token == FDT_END) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    return out.memory_count > 0;
+}
+
+} // namespace Fdt
@@ -0,0 +1,58 @@
+#ifndef MICRO32_FDT_H
+#define MICRO32_FDT_H
+
+// fdt.h
+// Minimal flattened device tree (DTB) reader for the boot memory map.
+//
+// The boot loader passes a DTB pointer in a1. parse_memory() walks the
+// structure block once and collects:
+//  - the `reg` ranges of every top-level memory node (`memory`, `memory@...`
+//    or device_type = "memory"), decoded with the root #address-cells /
+//    #size-cells
+//  - the `reg` ranges of every child of `/reserved-memory`, decoded with that
+//    node's own cell sizes (dynamically placed children without `reg` are
+//    skipped)
+//  - the entries of the memory reservation block (/memreserve/)
+//
+// The parser does not allocate and does not write to the blob. Results are
+// copied into a caller-provided MemoryInfo, so the blob may be overwritten
+// once parsing is done. It only reads memory within the header's totalsize
+// and rejects blobs whose offsets do not fit, so it can be run on host
+// against .dtb files.
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Fdt {
+
+constexpr uint32_t MAGIC = 0xD00DFEEDu;
+
+constexpr int MAX_MEMORY_RANGES = 4;
+constexpr int MAX_RESERVED_RANGES = 8;
+
+struct Range {
+    uint64_t base;
+    uint64_t size;
+};
+
+struct MemoryInfo {
+    Range memory[MAX_MEMORY_RANGES];
+    int memory_count;
+    Range reserved[MAX_RESERVED_RANGES];
+    int reserved_count;
+    bool truncated;       // more ranges than fit in the arrays
+};
+
+// True if `blob` starts with a plausible DTB header
+bool valid(const void* blob);
+
+// Size of the blob in bytes (header totalsize), 0 if not valid
+uint32_t total_size(const void* blob);
+
+// Collect the memory and reserved-memory ranges. Returns false if the blob
+// is malformed or describes no memory.
+bool parse_memory(const void* blob, MemoryInfo& out);
+
+} // namespace Fdt
+
+#endif // MICRO32_FDT_H
@@ -0,0 +1,236 @@
+/*
+ * micro32/hart_arena.cpp
+ *
+ * Per-hart arenas with a lock-free remote-free stack. See hart_arena.h.
+ *
+ * Notes:
+ *  - Only the owning hart ever touches an arena's free lists, page map and
+ *    counters; the remote-free stack head and counter (RemoteState) are
+ *    the only shared state and are accessed atomically.
+ *  - The remote stack is multi-producer / single-consumer, and the consumer
+ *    always takes the whole stack with exchange(), so there is no ABA issue.
+ *  - Requires the RISC-V A extension for the std::atomic operations.
+ */
+
+#include "hart_arena.h"
+#include "page_allocator.h"
+#include "cache.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace HartArena {
+
+constexpr uint8_t PAGE_UNASSIGNED = 0xFF;
+
+struct FreeObject {
+    FreeObject* next;
+};
+
+// The state other harts write gets a cache line to itself, and each arena
+// starts on its own line, so remote frees never pull the owner's fast-path
+// fields (free lists, counters) over to the other core
+struct alignas(Cache::LINE_SIZE) RemoteState {
+    std::atomic<FreeObject*> head;
+    std::atomic<uint32_t> frees;          // 32-bit: native AMO on RV32
+};
+
+struct alignas(Cache::LINE_SIZE) Arena {
+    uintptr_t start;
+    uintptr_t end;
+    std::size_t pages;
+    std::size_t next_page;                   // next page never given to a class
+
+    FreeObject* free_list[NUM_CLASSES];
+
+    // Owner-only counters
+    uint64_t allocs;
+    uint64_t local_frees;
+    uint64_t drained;
+
+    uint8_t page_class[MAX_ARENA_PAGES];
+
+    // Shared with other harts
+    RemoteState remote;
+};
+
+static Arena s_arenas[MAX_HARTS];
+static int s_harts = 0;
+
+#ifdef MICRO32_HOST
+static thread_local int t_host_hart = 0;
+
+void set_host_hart(int hart) {
+    t_host_hart = hart;
+}
+#endif
+
+int current_hart() {
+#ifdef MICRO32_HOST
+    return t_host_hart;
+#else
+    uintptr_t id;
+    asm volatile("csrr %0, mhartid" : "=r"(id));
+    return static_cast<int>(id);
+#endif
+}
+
+static inline int class_of(std::size_t size) {
+    int c = 0;
+    std::size_t s = MIN_SIZE;
+    while (s < size) {
+        s <<= 1;
+        c++;
+    }
+    return c;
+}
+
+static inline std::size_t class_size(int c) {
+    return MIN_SIZE << c;
+}
+
+// Arena that owns `addr`, or nullptr
+static Arena* owner_of(uintptr_t addr) {
+    for (int h = 0; h < s_harts; h++) {
+        if (addr >= s_arenas[h].start && addr < s_arenas[h].end) return &s_arenas[h];
+    }
+    return nullptr;
+}
+
+static inline void push_local(Arena& a, FreeObject* obj) {
+    std::size_t page = (reinterpret_cast<uintptr_t>(obj) - a.start) >> PageAllocator::PAGE_SHIFT;
+    int c = a.page_class[page];
+    obj->next = a.free_list[c];
+    a.free_list[c] = obj;
+}
+
+bool init(int harts, std::size_t bytes_per_hart) {
+    if (harts <= 0 || harts > MAX_HARTS) return false;
+
+    std::size_t pages = (bytes_per_hart + PageAllocator::PAGE_SIZE - 1) >> PageAllocator::PAGE_SHIFT;
+    if (pages == 0 || pages > MAX_ARENA_PAGES) return false;
+
+    for (int h = 0; h < harts; h++) {
+        void* mem = PageAllocator::alloc_pages_exact(pages, PageAllocator::Fill::Dirty);
+        if (mem == nullptr) return false;
+
+        Arena& a = s_arenas[h];
+        a.start = reinterpret_cast<uintptr_t>(mem);
+        a.end = a.start + (pages << PageAllocator::PAGE_SHIFT);
+        a.pages = pages;
+        a.next_page = 0;
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            a.free_list[c] = nullptr;
+        }
+        for (std::size_t p = 0; p < pages; p++) {
+            a.page_class[p] = PAGE_UNASSIGNED;
+        }
+        a.remote.head.store(nullptr, std::memory_order_relaxed);
+        a.remote.frees.store(0, std::memory_order_relaxed);
+        a.allocs = 0;
+        a.local_frees = 0;
+        a.drained = 0;
+    }
+
+    // Publish the arenas before other harts can see s_harts
+    std::atomic_thread_fence(std::memory_order_release);
+    s_harts = harts;
+    return true;
+}
+
+// Take everything other harts freed into this arena back onto local lists
+static bool drain_remote(Arena& a) {
+    FreeObject* obj = a.remote.head.exchange(nullptr, std::memory_order_acquire);
+    if (obj == nullptr) return false;
+
+    while (obj != nullptr) {
+        FreeObject* next = obj->next;
+        push_local(a, obj);
+        a.drained++;
+        obj = next;
+    }
+    return true;
+}
+
+// Assign a fresh page to class `c` and thread its objects onto the free list
+static bool refill(Arena& a, int c) {
+    if (a.next_page >= a.pages) return false;
+
+    std::size_t page = a.next_page++;
+    a.page_class[page] = static_cast<uint8_t>(c);
+
+    std::size_t size = class_size(c);
+    uintptr_t base = a.start + (page << PageAllocator::PAGE_SHIFT);
+    FreeObject* head = a.free_list[c];
+    for (std::size_t off = PageAllocator::PAGE_SIZE; off >= size; off -= size) {
+        FreeObject* obj = reinterpret_cast<FreeObject*>(base + off - size);
+        obj->next = head;
+        head = obj;
+    }
+    a.free_list[c] = head;
+    return true;
+}
+
+void* alloc(std::size_t size) {
+    if (size > MAX_SIZE) return nullptr;
+    int hart = current_hart();
+    if (hart < 0 || hart >= s_harts) return nullptr;
+
+    Arena& a = s_arenas[hart];
+    int c = class_of(size == 0 ? 1 : size);
+
+    FreeObject* obj = a.free_list[c];
+    if (obj == nullptr) {
+        // Reclaim remote frees first; only take a new page if that did not help
+        drain_remote(a);
+        obj = a.free_list[c];
+        if (obj == nullptr) {
+            if (!refill(a, c)) return nullptr;
+            obj = a.free_list[c];
+        }
+    }
+
+    a.free_list[c] = obj->next;
+    a.allocs++;
+    return obj;
+}
+
+void free(void* ptr) {
+    if (ptr == nullptr) return;
+
+    Arena* owner = owner_of(reinterpret_cast<uintptr_t>(ptr));
+    if (owner == nullptr) return;  // not from an arena
+
+    FreeObject* obj = static_cast<FreeObject*>(ptr);
+    int hart = current_hart();
+    if (owner == &s_arenas[hart]) {
+        push_local(*owner, obj);
+        owner->local_frees++;
+        return;
+    }
+
+    // Lock-free push onto the owner's remote stack
+    FreeObject* head = owner->remote.head.load(std::memory_order_relaxed);
+    do {
+        obj->next = head;
+    } while (!owner->remote.head.compare_exchange_weak(head, obj,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed));
+    owner->remote.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+Stats stats(int hart) {
+    Stats st = {};
+    if (hart < 0 || hart >= s_harts) return st;
+
+    const Arena& a = s_arenas[hart];
+    st.allocs = a.allocs;
+    st.local_frees = a.local_frees;
+    st.remote_frees = a.remote.frees.load(std::memory_order_relaxed);
+    st.drained = a.drained;
+    st.pages_used = a.next_page;
+    st.pages_total = a.pages;
+    return st;
+}
+
+} // namespace HartArena
@@ -0,0 +1,68 @@
+#ifndef MICRO32_HART_ARENA_H
+#define MICRO32_HART_ARENA_H
+
+// hart_arena.h
+// Per-hart small-object allocation for when both ESP32-P4 cores run.
+//
+// Design:
+//  - init() (called once, before the second hart starts) gives every hart
+//    its own arena: a contiguous run of pages from the page allocator.
+//  - Objects come in power-of-two size classes (16 B .. MAX_SIZE). Each
+//    arena keeps a private free list per class and hands out fresh pages
+//    to a class on demand; a per-page class map replaces object headers.
+//  - alloc() and frees of the caller's own objects touch only the caller's
+//    arena: no locks, no atomics.
+//  - Freeing another hart's object pushes it onto the owner's remote-free
+//    stack with a single compare-and-swap (AMO/LR-SC). The owner takes the
+//    whole stack with one atomic swap the next time a free list runs dry.
+//
+// The owning arena of a pointer is found from its address, so free() needs
+// no size or hart argument. Requests larger than MAX_SIZE return nullptr;
+// use the heap or the page allocator for those.
+
+#include <cstdint>
+#include <cstddef>
+
+namespace HartArena {
+
+constexpr int MAX_HARTS = 2;
+constexpr std::size_t MIN_SIZE = 16;
+constexpr std::size_t MAX_SIZE = 2048;
+constexpr int NUM_CLASSES = 8;  // 16, 32, ..., 2048
+
+// Upper bound on arena size (pages) so the class map can be static
+constexpr std::size_t MAX_ARENA_PAGES = 1024;  // 4 MiB
+
+struct Stats {
+    uint64_t allocs;         // objects handed out
+    uint64_t local_frees;    // objects freed by the owning hart
+    uint32_t remote_frees;   // objects freed by other harts (wraps)
+    uint64_t drained;        // remote frees reclaimed by the owner
+    std::size_t pages_used;  // arena pages assigned to a size class
+    std::size_t pages_total;
+};
+
+// Carve `bytes_per_hart` (rounded to pages) for each of `harts` arenas.
+// Must run before any other hart allocates.
+bool init(int harts, std::size_t bytes_per_hart);
+
+// Index of the calling hart (mhartid on target)
+int current_hart();
+
+#ifdef MICRO32_HOST
+// Host builds emulate harts with threads: bind the calling thread to a hart
+void set_host_hart(int hart);
+#endif
+
+// Allocate from the calling hart's arena; nullptr if size > MAX_SIZE or
+// the arena is exhausted
+void* alloc(std::size_t size);
+
+// Free an object from any hart's arena (nullptr is ignored)
+void free(void* ptr);
+
+Stats stats(int hart);
+
+} // namespace HartArena
+
+#endif // MICRO32_HART_ARENA_H
@@ -0,0 +1,463 @@
+/*
+ * micro32/heap.cpp
+ *
+ * TLSF (two-level segregated fit) heap. See heap.h for the design.
+ *
+ * Block layout (W = sizeof(uintptr_t)), `b` is the block address:
+ *
+ *   b + 0   prev_phys   last word of the previous block; valid only when
+ *                       the previous block is free
+ *   b + W   header      block size | FLAG_FREE | FLAG_PREV_FREE
+ *   b + 2W  payload     next_free / prev_free links while the block is free
+ *   b+size  next block  (its prev_phys overlaps our last payload word)
+ *
+ * `size` is the distance to the next block and a multiple of HEAP_ALIGN,
+ * so the usable payload is size - W. The pool ends with a zero-sized,
+ * permanently used sentinel block so merging never runs off the end.
+ */
+
+#include "heap.h"
+#include "mem_fill.h"
+#include "mem_stats.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace Heap {
+
+struct Block {
+    Block* prev_phys;
+    uintptr_t header;
+    Block* next_free;
+    Block* prev_free;
+};
+
+constexpr std::size_t W = sizeof(uintptr_t);
+constexpr uintptr_t FLAG_FREE = 1u;
+constexpr uintptr_t FLAG_PREV_FREE = 2u;
+constexpr uintptr_t FLAG_MASK = 3u;
+
+static constexpr unsigned log2_of(std::size_t v) {
+    return v <= 1 ? 0 : 1 + log2_of(v >> 1);
+}
+
+// Bin geometry
+constexpr unsigned ALIGN_LOG2 = log2_of(HEAP_ALIGN);
+constexpr unsigned SL_LOG2 = 4;
+constexpr unsigned SL_COUNT = 1u << SL_LOG2;
+constexpr unsigned FL_SHIFT = SL_LOG2 + ALIGN_LOG2;
+constexpr unsigned FL_MAX = 31;  // blocks up to 2 GiB
+constexpr unsigned FL_COUNT = FL_MAX - FL_SHIFT + 1;
+constexpr std::size_t SMALL_BLOCK = std::size_t(1) << FL_SHIFT;
+
+// A free block must hold the two list links plus the next block's prev_phys
+constexpr std::size_t MIN_BLOCK = (4 * W + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+constexpr std::size_t MAX_BLOCK = std::size_t(1) << FL_MAX;
+
+static uint32_t s_fl_bitmap = 0;
+static uint32_t s_sl_bitmap[FL_COUNT];
+static Block* s_bins[FL_COUNT][SL_COUNT];
+
+static std::size_t s_pool_size = 0;
+static std::size_t s_used = 0;
+static std::size_t s_peak = 0;
+
+// --- Block helpers ---
+
+static inline std::size_t block_size(const Block* b) {
+    return b->header & ~FLAG_MASK;
+}
+
+static inline void set_size(Block* b, std::size_t size) {
+    b->header = size | (b->header & FLAG_MASK);
+}
+
+static inline bool is_free(const Block* b) {
+    return (b->header & FLAG_FREE) != 0;
+}
+
+static inline bool is_prev_free(const Block* b) {
+    return (b->header & FLAG_PREV_FREE) != 0;
+}
+
+static inline void set_flag(Block* b, uintptr_t flag, bool on) {
+    if (on) b->header |= flag;
+    else b->header &= ~flag;
+}
+
+static inline void* payload_of(Block* b) {
+    return reinterpret_cast<uint8_t*>(b) + 2 * W;
+}
+
+static inline Block* block_of(const void* p) {
+    return reinterpret_cast<Block*>(reinterpret_cast<uintptr_t>(p) - 2 * W);
+}
+
+static inline Block* next_phys(Block* b) {
+    return reinterpret_cast<Block*>(reinterpret_cast<uintptr_t>(b) + block_size(b));
+}
+
+static inline unsigned fls(std::size_t v) {
+    return static_cast<unsigned>(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(v));
+}
+
+static inline unsigned ffs(uint32_t v) {
+    return static_cast<unsigned>(__builtin_ctz(v));
+}
+
+// Block size needed for a request of `n` bytes
+static inline std::size_t adjust_size(std::size_t n) {
+    std::size_t size = (n + W + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+    return size < MIN_BLOCK ? MIN_BLOCK : size;
+}
+
+// --- Bin mapping ---
+
+static inline void mapping_insert(std::size_t size, unsigned& fl, unsigned& sl) {
+    if (size < SMALL_BLOCK) {
+        fl = 0;
+        sl = static_cast<unsigned>(size >> ALIGN_LOG2);
+    } else {
+        unsigned f = fls(size);
+        sl = static_cast<unsigned>(size >> (f - SL_LOG2)) ^ SL_COUNT;
+        fl = f - FL_SHIFT + 1;
+    }
+}
+
+// Round up so that any block in the resulting bin is large enough
+static inline void mapping_search(std::size_t size, unsigned& fl, unsigned& sl) {
+    if (size >= SMALL_BLOCK) {
+        size += (std::size_t(1) << (fls(size) - SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static Block* find_suitable(unsigned& fl, unsigned& sl) {
+    if (fl >= FL_COUNT) return nullptr;
+
+    uint32_t sl_map = s_sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        uint32_t fl_map = (fl + 1 < 32) ? (s_fl_bitmap & (~0u << (fl + 1))) : 0;
+        if (fl_map == 0) return nullptr;
+        fl = ffs(fl_map);
+        sl_map = s_sl_bitmap[fl];
+    }
+    sl = ffs(sl_map);
+    return s_bins[fl][sl];
+}
+
+static void remove_free(Block* b, unsigned fl, unsigned sl) {
+    Block* prev = b->prev_free;
+    Block* next = b->next_free;
+    if (next) next->prev_free = prev;
+    if (prev) prev->next_free = next;
+
+    if (s_bins[fl][sl] == b) {
+        s_bins[fl][sl] = next;
+        if (next == nullptr) {
+            s_sl_bitmap[fl] &= ~(1u << sl);
+            if (s_sl_bitmap[fl] == 0) s_fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+static void remove_block(Block* b) {
+    unsigned fl, sl;
+    mapping_insert(block_size(b), fl, sl);
+    remove_free(b, fl, sl);
+}
+
+static void insert_block(Block* b) {
+    unsigned fl, sl;
+    mapping_insert(block_size(b), fl, sl);
+
+    Block* head = s_bins[fl][sl];
+    b->prev_free = nullptr;
+    b->next_free = head;
+    if (head) head->prev_free = b;
+    s_bins[fl][sl] = b;
+    s_fl_bitmap |= 1u << fl;
+    s_sl_bitmap[fl] |= 1u << sl;
+}
+
+// Mark `b` free and tell its physical successor
+static void mark_free(Block* b) {
+    set_flag(b, FLAG_FREE, true);
+    Block* next = next_phys(b);
+    next->prev_phys = b;
+    set_flag(next, FLAG_PREV_FREE, true);
+}
+
+static void mark_used(Block* b) {
+    set_flag(b, FLAG_FREE, false);
+    set_flag(next_phys(b), FLAG_PREV_FREE, false);
+}
+
+// Split `b` to exactly `size` if the remainder can stand as a block; the
+// remainder goes back to the free lists
+static void trim(Block* b, std::size_t size) {
+    if (block_size(b) < size + MIN_BLOCK) return;
+
+    Block* rest = reinterpret_cast<Block*>(reinterpret_cast<uintptr_t>(b) + size);
+    rest->header = 0;
+    set_size(rest, block_size(b) - size);
+    set_size(b, size);
+    mark_free(rest);
+    set_flag(rest, FLAG_PREV_FREE, is_free(b));
+    if (is_free(b)) rest->prev_phys = b;
+    insert_block(rest);
+}
+
+// Take a free block off the lists and hand it out
+static void* use_block(Block* b, std::size_t size) {
+    remove_block(b);
+    set_flag(b, FLAG_FREE, false);
+    trim(b, size);
+    mark_used(b);
+
+    s_used += block_size(b);
+    if (s_used > s_peak) s_peak = s_used;
+    return payload_of(b);
+}
+
+bool init(void* pool, std::size_t size) {
+    if (pool == nullptr) return false;
+    uintptr_t start = reinterpret_cast<uintptr_t>(pool);
+    uintptr_t end = start + size;
+
+    // First payload must be aligned and its header inside the pool
+    uintptr_t payload = (start + W + HEAP_ALIGN - 1) & ~(uintptr_t)(HEAP_ALIGN - 1);
+    if (payload + MIN_BLOCK + W > end) return false;
+
+    Block* first = block_of(reinterpret_cast<void*>(payload));
+    std::size_t first_size = (end - reinterpret_cast<uintptr_t>(first) - 2 * W) & ~(HEAP_ALIGN - 1);
+    if (first_size > MAX_BLOCK - HEAP_ALIGN) first_size = MAX_BLOCK - HEAP_ALIGN;
+
+    s_fl_bitmap = 0;
+    for (unsigned fl = 0; fl < FL_COUNT; fl++) {
+        s_sl_bitmap[fl] = 0;
+        for (unsigned sl = 0; sl < SL_COUNT; sl++) {
+            s_bins[fl][sl] = nullptr;
+        }
+    }
+
+    first->header = first_size;
+
+    // Zero-sized sentinel, permanently used
+    Block* sentinel = next_phys(first);
+    sentinel->header = 0;
+
+    mark_free(first);
+    insert_block(first);
+
+    s_pool_size = first_size;
+    s_used = 0;
+    s_peak = 0;
+    return true;
+}
+
+// Report an allocation attempt to MemStats and pass the result through
+static inline void* account(void* p, std::size_t n, uint64_t start) {
+#if MICRO32_MEM_STATS
+    if (p) MemStats::record_alloc(MemStats::SOURCE_HEAP, n, block_size(block_of(p)), MemStats::now() - start);
+    else MemStats::record_failure(MemStats::SOURCE_HEAP, n);
+#else
+    (void)n;
+    (void)start;
+#endif
+    return p;
+}
+
+static void* alloc_block(std::size_t n) {
+    if (n == 0 || n >= MAX_BLOCK - HEAP_ALIGN) return nullptr;
+
+    std::size_t size = adjust_size(n);
+    unsigned fl, sl;
+    mapping_search(size, fl, sl);
+
+    Block* b = find_suitable(fl, sl);
+    if (b == nullptr) return nullptr;
+    return use_block(b, size);
+}
+
+static void* alloc_aligned_block(std::size_t align, std::size_t n) {
+    if (align <= HEAP_ALIGN) return alloc_block(n);
+    if ((align & (align - 1)) != 0 || n == 0) return nullptr;
+
+    // Room for the request, the worst-case alignment gap and a leading
+    // free block carved out of that gap
+    std::size_t size = adjust_size(n);
+    std::size_t search = size + align + MIN_BLOCK;
+    if (search >= MAX_BLOCK) return nullptr;
+
+    unsigned fl, sl;
+    mapping_search(search, fl, sl);
+    Block* b = find_suitable(fl, sl);
+    if (b == nullptr) return nullptr;
+
+    uintptr_t payload = reinterpret_cast<uintptr_t>(payload_of(b));
+    uintptr_t aligned = (payload + align - 1) & ~(uintptr_t)(align - 1);
+    if (aligned != payload && aligned - payload < MIN_BLOCK) {
+        aligned = (payload + MIN_BLOCK + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    std::size_t gap = aligned - payload;
+    if (gap > 0) {
+        // Split off the gap as its own free block
+        remove_block(b);
+        Block* rest = reinterpret_cast<Block*>(reinterpret_cast<uintptr_t>(b) + gap);
+        rest->header = 0;
+        set_size(rest, block_size(b) - gap);
+        set_size(b, gap);
+        rest->prev_phys = b;
+        set_flag(rest, FLAG_PREV_FREE, true);
+        mark_free(rest);
+        insert_block(b);
+        insert_block(rest);
+        b = rest;
+    }
+    return use_block(b, size);
+}
+
+void* alloc(std::size_t n) {
+    uint64_t start = MemStats::now();
+    return account(alloc_block(n), n, start);
+}
+
+void* alloc_aligned(std::size_t align, std::size_t n) {
+    uint64_t start = MemStats::now();
+    return account(alloc_aligned_block(align, n), n, start);
+}
+
+void free(void* ptr) {
+    if (ptr == nullptr) return;
+
+    Block* b = block_of(ptr);
+    s_used -= block_size(b);
+#if MICRO32_MEM_STATS
+    MemStats::record_free(MemStats::SOURCE_HEAP, block_size(b));
+#endif
+
+    // Merge with the previous block
+    if (is_prev_free(b)) {
+        Block* prev = b->prev_phys;
+        remove_block(prev);
+        set_size(prev, block_size(prev) + block_size(b));
+        b = prev;
+    }
+
+    // Merge with the next block
+    Block* next = next_phys(b);
+    if (is_free(next)) {
+        remove_block(next);
+        set_size(b, block_size(b) + block_size(next));
+    }
+
+    mark_free(b);
+    insert_block(b);
+}
+
+std::size_t usable_size(const void* ptr) {
+    return ptr ? block_size(block_of(ptr)) - W : 0;
+}
+
+Stats stats() {
+    Stats st = {};
+    st.pool_size = s_pool_size;
+    st.used = s_used;
+    st.peak_used = s_peak;
+    st.free_bytes = s_pool_size - s_used;
+
+    // The largest free block is in the highest non-empty bin
+    if (s_fl_bitmap) {
+        unsigned fl = fls(s_fl_bitmap);
+        unsigned sl = fls(s_sl_bitmap[fl]);
+        std::size_t largest = 0;
+        for (Block* b = s_bins[fl][sl]; b; b = b->next_free) {
+            if (block_size(b) > largest) largest = block_size(b);
+        }
+        st.largest_free = largest - W;
+    }
+    return st;
+}
+
+} // namespace Heap
+
+#ifndef MICRO32_HOST
+
+// --- C and C++ allocation entry points (target builds only) ---
+
+extern "C" {
+
+void* malloc(std::size_t size) {
+    return Heap::alloc(size);
+}
+
+void free(void* ptr) {
+    Heap::free(ptr);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return nullptr;
+    void* p = Heap::alloc(count * size);
+    if (p) MemFill::zero(p, count * size);
+    return p;
+}
+
+void* realloc(void* ptr, std::size_t size) {
+    if (ptr == nullptr) return Heap::alloc(size);
+    if (size == 0) {
+        Heap::free(ptr);
+        return nullptr;
+    }
+
+    std::size_t old_size = Heap::usable_size(ptr);
+    if (size <= old_size) return ptr;
+
+    void* p = Heap::alloc(size);
+    if (p) {
+        memcpy(p, ptr, old_size);
+        Heap::free(ptr);
+    }
+    return p;
+}
+
+void* aligned_alloc(std::size_t align, std::size_t size) {
+    return Heap::alloc_aligned(align, size);
+}
+
+} // extern "C"
+
+// The kernel is built without exceptions: running out of memory in
+// operator new is fatal.
+static void* checked_alloc(std::size_t size) {
+    void* p = Heap::alloc(size ? size : 1);
+    if (p == nullptr) __builtin_trap();
+    return p;
+}
+
+void* operator new(std::size_t size) {
+    return checked_alloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return checked_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    Heap::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    Heap::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    Heap::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    Heap::free(ptr);
+}
+
+#endif // MICRO32_HOST
@@ -0,0 +1,70 @@
+#ifndef MICRO32_HEAP_H
+#define MICRO32_HEAP_H
+
+// heap.h
+// General-purpose kernel heap with bounded worst-case latency (TLSF: two-level
+// segregated fit).
+//
+// Design:
+//  - Free blocks are binned by size into a first level (power of two) and a
+//    second level (16 linear subdivisions per power of two). Two bitmaps
+//    record which bins are non-empty, so finding a fitting block is two
+//    bit scans and splitting/merging touch only physical neighbours:
+//    alloc() and free() are O(1).
+//  - Every block carries a one-word header (size + flags); the link to the
+//    previous physical block lives in the last word of that block's payload
+//    and is only used while it is free. Block sizes are multiples of
+//    HEAP_ALIGN, so payloads stay aligned from one block to the next.
+//  - Payloads are aligned to HEAP_ALIGN (MICRO32_HEAP_ALIGN, default 8);
+//    alloc_aligned() serves stricter alignments.
+//
+// The heap manages one pool, normally a block of pages taken from the page
+// allocator over MemoryManager::get_usable_region() (see kernel_main).
+// On target builds malloc/free/calloc/realloc and the global operator
+// new/delete are routed here; host builds only expose the Heap:: API.
+//
+// Thread-safety: none; callers must serialise access.
+
+#include <cstdint>
+#include <cstddef>
+
+#ifndef MICRO32_HEAP_ALIGN
+#define MICRO32_HEAP_ALIGN 8
+#endif
+
+namespace Heap {
+
+constexpr std::size_t HEAP_ALIGN = MICRO32_HEAP_ALIGN;
+
+static_assert((HEAP_ALIGN & (HEAP_ALIGN - 1)) == 0, "heap alignment must be a power of two");
+static_assert(HEAP_ALIGN >= sizeof(void*), "heap alignment must be at least a word");
+
+struct Stats {
+    std::size_t pool_size;      // bytes managed
+    std::size_t used;           // bytes in allocated blocks (including headers)
+    std::size_t peak_used;      // high-water mark of `used`
+    std::size_t free_bytes;     // bytes in free blocks
+    std::size_t largest_free;   // largest single allocation currently possible
+};
+
+// Take over [pool, pool + size) as the heap. Returns false if `pool` is
+// null or too small; the heap then stays empty and every alloc fails.
+bool init(void* pool, std::size_t size);
+
+// Allocate `size` bytes aligned to HEAP_ALIGN; nullptr if out of memory
+void* alloc(std::size_t size);
+
+// Allocate `size` bytes aligned to `align` (power of two)
+void* alloc_aligned(std::size_t align, std::size_t size);
+
+// Release a block from alloc()/alloc_aligned(); nullptr is ignored
+void free(void* ptr);
+
+// Usable size of an allocated block
+std::size_t usable_size(const void* ptr);
+
+Stats stats();
+
+} // namespace Heap
+
+#endif // MICRO32_HEAP_H
@@ -0,0 +1,94 @@
+/*
+ * micro32/host/bench_fill.cpp
+ *
+ * MemFill::benchmark() throughput per strategy over a range of sizes, plus
+ * a check that every strategy leaves the buffer zeroed.
+ *
+ * Notes:
+ *  - Sizes span the Auto thresholds (CACHE_BLOCK_MIN_BYTES, DMA_MIN_BYTES)
+ *    so the table shows where each strategy starts to pay off.
+ *  - Host builds have no Zicboz, so the cbo.zero column shows "-".
+ *    Dma runs through the DMA model (Dma::Mock), which copies in software:
+ *    its figure tracks descriptor and cache-maintenance overhead, not the
+ *    real GDMA bandwidth.
+ *  - MB/s are 10^6 bytes per second, as benchmark() reports them.
+ */
+
+#include "mem_fill.h"
+#include "dma.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+constexpr std::size_t MAX_BYTES = 8u * 1024u * 1024u;
+constexpr std::size_t SIZES[] = {
+    1024, 4096, 64u * 1024u, 256u * 1024u, 1024u * 1024u, MAX_BYTES,
+};
+
+// Table columns, in the order benchmark() measures them
+constexpr MemFill::Strategy STRATEGIES[] = {MemFill::Strategy::Words, MemFill::Strategy::CacheBlock, MemFill::Strategy::Dma};
+constexpr int NUM_STRATEGIES = sizeof(STRATEGIES) / sizeof(STRATEGIES[0]);
+
+static const char* name(MemFill::Strategy s) {
+    switch (s) {
+    case MemFill::Strategy::Words: return "words";
+    case MemFill::Strategy::CacheBlock: return "cbo.zero";
+    case MemFill::Strategy::Dma: return "dma";
+    default: return "auto";
+    }
+}
+
+static bool all_zero(const uint8_t* p, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; i++) {
+        if (p[i] != 0) return false;
+    }
+    return true;
+}
+
+int main() {
+    Dma::Mock::set_auto_complete(true);
+    uint8_t* buffer = static_cast<uint8_t*>(aligned_alloc(MemFill::CBO_BLOCK, MAX_BYTES));
+    bool failed = false;
+
+    printf("%-10s", "bytes");
+    for (MemFill::Strategy s : STRATEGIES) {
+        printf(" %10s", name(s));
+    }
+    printf("   (MB/s)\n");
+
+    for (std::size_t bytes : SIZES) {
+        memset(buffer, 0xA5, bytes);
+        MemFill::BenchResult results[NUM_STRATEGIES];
+        int n = MemFill::benchmark(buffer, bytes, results, NUM_STRATEGIES);
+        if (!all_zero(buffer, bytes)) {
+            printf("FAIL: buffer not zeroed after benchmark at %zu bytes\n", bytes);
+            failed = true;
+        }
+
+        printf("%-10zu", bytes);
+        for (MemFill::Strategy s : STRATEGIES) {
+            int i = 0;
+            while (i < n && results[i].strategy != s) i++;
+            if (i < n) {
+                printf(" %10u", results[i].mb_per_s);
+            } else {
+                printf(" %10s", "-");
+            }
+        }
+        printf("\n");
+    }
+
+    // Each strategy on its own, including an unaligned head and tail
+    for (MemFill::Strategy s : STRATEGIES) {
+        memset(buffer, 0xA5, MAX_BYTES);
+        MemFill::zero(buffer + 3, MAX_BYTES - 10, s);
+        if (buffer[2] != 0xA5 || !all_zero(buffer + 3, MAX_BYTES - 10) || buffer[MAX_BYTES - 7] != 0xA5) {
+            printf("FAIL: %s zeroed the wrong range\n", name(s));
+            failed = true;
+        }
+    }
+
+    ::free(buffer);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * micro32/host/bench_heap.cpp
+ *
+ * TLSF heap against a naive first-fit baseline on the same workload.
+ *
+ * Notes:
+ *  - Both allocators manage a 1 MiB pool. The workload keeps about 400
+ *    blocks live with log-uniform sizes from 16 B to 4 KiB, freeing a
+ *    random one or allocating a new one at each step.
+ *  - The baseline keeps one address-ordered free list: alloc walks it for
+ *    the first block that fits (O(free blocks)), free inserts in order and
+ *    merges with both neighbours.
+ *  - Every block is filled with a tag byte that is checked on free; the
+ *    run fails if any block was overwritten.
+ *  - TLSF times include the MemStats hooks, which read the host clock on
+ *    every alloc; the baseline has no instrumentation.
+ */
+
+#include "heap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t POOL_BYTES = 1024u * 1024u;
+constexpr int STEPS = 200000;
+constexpr std::size_t TARGET_LIVE = 400;
+
+// --- Naive first-fit baseline ---
+
+namespace FirstFit {
+
+struct Block {
+    std::size_t size;  // whole block including this header
+    Block* next;       // free blocks only
+};
+
+constexpr std::size_t HEADER = sizeof(std::size_t);
+constexpr std::size_t MIN_BLOCK = sizeof(Block);
+constexpr std::size_t ALIGN = 8;
+
+static Block* s_free = nullptr;
+
+static void init(void* pool, std::size_t size) {
+    s_free = static_cast<Block*>(pool);
+    s_free->size = size & ~(ALIGN - 1);
+    s_free->next = nullptr;
+}
+
+static void* alloc(std::size_t n) {
+    std::size_t need = (n + HEADER + ALIGN - 1) & ~(ALIGN - 1);
+    if (need < MIN_BLOCK) need = MIN_BLOCK;
+
+    for (Block** link = &s_free; *link; link = &(*link)->next) {
+        Block* b = *link;
+        if (b->size < need) continue;
+        if (b->size - need >= MIN_BLOCK) {
+            Block* rest = reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(b) + need);
+            rest->size = b->size - need;
+            rest->next = b->next;
+            *link = rest;
+            b->size = need;
+        } else {
+            *link = b->next;
+        }
+        return reinterpret_cast<uint8_t*>(b) + HEADER;
+    }
+    return nullptr;
+}
+
+static void free(void* p) {
+    Block* b = reinterpret_cast<Block*>(static_cast<uint8_t*>(p) - HEADER);
+    Block* prev = nullptr;
+    Block* next = s_free;
+    while (next && next < b) {
+        prev = next;
+        next = next->next;
+    }
+
+    b->next = next;
+    if (next && reinterpret_cast<uint8_t*>(b) + b->size == reinterpret_cast<uint8_t*>(next)) {
+        b->size += next->size;
+        b->next = next->next;
+    }
+    if (prev && reinterpret_cast<uint8_t*>(prev) + prev->size == reinterpret_cast<uint8_t*>(b)) {
+        prev->size += b->size;
+        prev->next = b->next;
+    } else if (prev) {
+        prev->next = b;
+    } else {
+        s_free = b;
+    }
+}
+
+} // namespace FirstFit
+
+// --- Workload ---
+
+struct Live {
+    uint8_t* p;
+    std::size_t size;
+    uint8_t tag;
+};
+
+struct Result {
+    std::vector<uint64_t> alloc_ns;
+    std::vector<uint64_t> free_ns;
+    uint64_t failures;
+    bool corrupted;
+};
+
+template <typename Alloc, typename Free>
+static Result run(Alloc alloc_fn, Free free_fn) {
+    Result r = {{}, {}, 0, false};
+    std::mt19937 rng(777);
+    std::vector<Live> live;
+
+    auto release = [&](std::size_t i) {
+        Live b = live[i];
+        for (std::size_t k = 0; k < b.size; k++) {
+            if (b.p[k] != b.tag) {
+                r.corrupted = true;
+                break;
+            }
+        }
+        live[i] = live.back();
+        live.pop_back();
+
+        auto t0 = Clock::now();
+        free_fn(b.p);
+        r.free_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+    };
+
+    for (int step = 0; step < STEPS; step++) {
+        bool grow = live.size() < TARGET_LIVE ? (rng() % 4 != 0) : (rng() % 4 == 0);
+        if (!grow && !live.empty()) {
+            release(rng() % live.size());
+            continue;
+        }
+
+        // Log-uniform 16 B .. 4 KiB
+        std::size_t size = std::size_t(16) << (rng() % 8);
+        size += rng() % size;
+
+        auto t0 = Clock::now();
+        void* p = alloc_fn(size);
+        r.alloc_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+        if (p == nullptr) {
+            r.failures++;
+            if (!live.empty()) release(rng() % live.size());
+            continue;
+        }
+
+        Live b = {static_cast<uint8_t*>(p), size, static_cast<uint8_t>(step)};
+        memset(b.p, b.tag, b.size);
+        live.push_back(b);
+    }
+    while (!live.empty()) release(live.size() - 1);
+    return r;
+}
+
+static void report(const char* name, std::vector<uint64_t>& ns) {
+    std::sort(ns.begin(), ns.end());
+    uint64_t sum = 0;
+    for (uint64_t v : ns) sum += v;
+    printf("  %-6s mean %5llu ns  p50 %5llu  p99 %5llu  max %7llu\n", name,
+           static_cast<unsigned long long>(sum / ns.size()),
+           static_cast<unsigned long long>(ns[ns.size() / 2]),
+           static_cast<unsigned long long>(ns[ns.size() * 99 / 100]),
+           static_cast<unsigned long long>(ns.back()));
+}
+
+int main() {
+    void* pool = aligned_alloc(64, POOL_BYTES);
+    bool failed = false;
+
+    if (!Heap::init(pool, POOL_BYTES)) {
+        printf("FAIL: Heap::init\n");
+        return 1;
+    }
+    Result tlsf = run([](std::size_t n) { return Heap::alloc(n); }, [](void* p) { Heap::free(p); });
+    Heap::Stats hs = Heap::stats();
+    printf("tlsf       (%llu failed allocs, peak %zu bytes)\n",
+           static_cast<unsigned long long>(tlsf.failures), hs.peak_used);
+    report("alloc", tlsf.alloc_ns);
+    report("free", tlsf.free_ns);
+    if (tlsf.corrupted || hs.used != 0 || hs.largest_free + 64 < hs.free_bytes) {
+        printf("FAIL: tlsf corrupted or pool not restored\n");
+        failed = true;
+    }
+
+    FirstFit::init(pool, POOL_BYTES);
+    Result ff = run([](std::size_t n) { return FirstFit::alloc(n); }, [](void* p) { FirstFit::free(p); });
+    printf("first-fit  (%llu failed allocs)\n", static_cast<unsigned long long>(ff.failures));
+    report("alloc", ff.alloc_ns);
+    report("free", ff.free_ns);
+    if (ff.corrupted) {
+        printf("FAIL: first-fit corrupted\n");
+        failed = true;
+    }
+
+    ::free(pool);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * micro32/host/bench_lcd.cpp
+ *
+ * LCD driver throughput on the recording MMIO backend. For each workload
+ * reports register writes, bytes on the wire and simulated wire time per
+ * operation, so driver efficiency regressions show up on a build box.
+ *
+ * Notes:
+ *  - DMA transfers complete as soon as they start (Dma::Mock
+ *    auto-complete), so their bytes count towards the operation that
+ *    queued them.
+ *  - Wire time is simulated at the backend's default 40 MHz SPI clock.
+ *  - The bytes-per-pixel section compares addressing every pixel (CASET,
+ *    RASET, RAMWR per drawPixel) with one window streamed in a single
+ *    RAMWR burst, and fails if the burst path costs more than
+ *    MAX_BURST_BYTES_PER_PIXEL.
+ */
+
+#include "lcd.h"
+#include "dma.h"
+#include "mmio.h"
+#include <cstdint>
+#include <cstdio>
+
+namespace lcd = LCDDriver;
+
+// RGB565 is 2 bytes per pixel; allow a little for the window commands
+constexpr double MAX_BURST_BYTES_PER_PIXEL = 2.1;
+
+constexpr int AREA = 32;  // side of the square drawn for bytes per pixel
+
+// Run `op` `count` times from clean counters and print per-op figures
+template <typename Op>
+static void measure(const char* name, int count, Op op) {
+    Dma::wait_all();
+    Mmio::Host::reset_stats();
+    for (int i = 0; i < count; i++) op(i);
+    Dma::wait_all();
+
+    Mmio::Host::Stats st = Mmio::Host::stats();
+    printf("%-24s %8llu %10llu %10llu\n", name,
+           static_cast<unsigned long long>(st.writes / count),
+           static_cast<unsigned long long>(st.bytes_on_wire / count),
+           static_cast<unsigned long long>(st.wire_ns / count));
+}
+
+// Wire bytes per pixel of drawing the AREA x AREA square with `draw`
+template <typename Draw>
+static double bytes_per_pixel(const char* name, Draw draw) {
+    Dma::wait_all();
+    Mmio::Host::reset_stats();
+    draw();
+    Dma::wait_all();
+
+    double bpp = static_cast<double>(Mmio::Host::stats().bytes_on_wire) / (AREA * AREA);
+    printf("%-24s %12.2f\n", name, bpp);
+    return bpp;
+}
+
+int main() {
+    lcd::initialize();
+    Dma::Mock::set_auto_complete(true);
+
+    printf("%-24s %8s %10s %10s\n", "operation", "writes", "bytes", "wire_ns");
+
+    measure("clearScreen", 4, [](int i) {
+        lcd::clearScreen(static_cast<uint16_t>(0x1111 * i));
+    });
+    measure("Print 24 chars", 50, [](int i) {
+        lcd::Print("Hello, World! 0123456789", 0, (i % 40) * lcd::GLYPH_HEIGHT, 0xFFFF);
+    });
+    measure("Print int", 50, [](int i) {
+        lcd::Print(-1234567 + i, 0, 0, 0x07E0);
+    });
+    measure("fillRect 40x40", 100, [](int i) {
+        lcd::fillRect(i % 200, i % 280, 40, 40, 0xF800);
+    });
+    measure("fillRect 240x1", 100, [](int i) {
+        lcd::fillRect(0, i, lcd::LCD_WIDTH, 1, 0x001F);
+    });
+    measure("drawPixel", 1000, [](int i) {
+        lcd::drawPixel(i % lcd::LCD_WIDTH, i / lcd::LCD_WIDTH, 0xFFFF);
+    });
+
+    static uint16_t pixels[AREA * AREA];
+    for (int i = 0; i < AREA * AREA; i++) pixels[i] = static_cast<uint16_t>(i * 37);
+
+    printf("\n%-24s %12s\n", "32x32 area", "bytes/pixel");
+    double per_pixel = bytes_per_pixel("drawPixel per pixel", [] {
+        for (int y = 0; y < AREA; y++) {
+            for (int x = 0; x < AREA; x++) lcd::drawPixel(x, y, pixels[y * AREA + x]);
+        }
+    });
+    double burst = bytes_per_pixel("setWindow+writePixels", [] {
+        lcd::setWindow(0, 0, AREA - 1, AREA - 1);
+        lcd::writePixels(pixels, AREA * AREA);
+    });
+    bytes_per_pixel("fillRect", [] {
+        lcd::fillRect(0, 0, AREA, AREA, 0x07E0);
+    });
+    printf("%-24s %11.1fx\n", "burst saving", per_pixel / burst);
+
+    if (burst > MAX_BURST_BYTES_PER_PIXEL) {
+        printf("FAIL: burst path costs %.2f bytes/pixel\n", burst);
+        return 1;
+    }
+    return 0;
+}
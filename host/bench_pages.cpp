@@ -0,0 +1,143 @@
+/*
+ * micro32/host/bench_pages.cpp
+ *
+ * Page allocator latency and fragmentation under a randomized workload on
+ * a 32 MiB simulated region.
+ *
+ * Notes:
+ *  - The workload fills the region to about 75% with blocks of random
+ *    order (small orders more likely), then churns: each step frees a
+ *    random live block or allocates a new one.
+ *  - Every block is tagged in its first and last word; a tag found
+ *    overwritten means two allocations overlapped and the run fails.
+ *  - After freeing everything the free page count and largest order must
+ *    match the freshly initialised allocator.
+ */
+
+#include "page_allocator.h"
+#include "mem_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t REGION_BYTES = 32u * 1024u * 1024u;
+constexpr int CHURN_STEPS = 200000;
+constexpr unsigned MAX_TEST_ORDER = 6;
+
+struct Live {
+    uint32_t* block;
+    unsigned order;
+    uint32_t tag;
+};
+
+static std::vector<uint64_t> s_alloc_ns;
+static std::vector<uint64_t> s_free_ns;
+static bool s_failed = false;
+
+static uint32_t* last_word(const Live& b) {
+    return b.block + (PageAllocator::PAGE_SIZE << b.order) / sizeof(uint32_t) - 1;
+}
+
+static bool allocate(std::vector<Live>& live, std::mt19937& rng, uint32_t tag) {
+    // Order k with probability ~ 2^-(k+1)
+    unsigned order = 0;
+    while (order < MAX_TEST_ORDER && (rng() & 1)) order++;
+
+    auto t0 = Clock::now();
+    void* p = PageAllocator::alloc_pages(order, PageAllocator::Fill::Dirty);
+    s_alloc_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+    if (p == nullptr) return false;
+
+    Live b = {static_cast<uint32_t*>(p), order, tag};
+    b.block[0] = tag;
+    *last_word(b) = tag;
+    live.push_back(b);
+    return true;
+}
+
+static void release(std::vector<Live>& live, std::size_t i) {
+    Live b = live[i];
+    if (b.block[0] != b.tag || *last_word(b) != b.tag) {
+        printf("FAIL: block %p (order %u) overwritten\n", static_cast<void*>(b.block), b.order);
+        s_failed = true;
+    }
+    live[i] = live.back();
+    live.pop_back();
+
+    auto t0 = Clock::now();
+    PageAllocator::free_pages(b.block);
+    s_free_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+}
+
+static void report(const char* name, std::vector<uint64_t>& ns) {
+    std::sort(ns.begin(), ns.end());
+    uint64_t sum = 0;
+    for (uint64_t v : ns) sum += v;
+    printf("%-6s n=%-7zu mean %5llu ns  p50 %5llu  p99 %5llu  max %7llu\n", name, ns.size(),
+           static_cast<unsigned long long>(sum / ns.size()),
+           static_cast<unsigned long long>(ns[ns.size() / 2]),
+           static_cast<unsigned long long>(ns[ns.size() * 99 / 100]),
+           static_cast<unsigned long long>(ns.back()));
+}
+
+static void report_fragmentation(const char* when) {
+    MemStats::Stats st = MemStats::snapshot(MemStats::SOURCE_PAGES);
+    PageAllocator::Stats pages = PageAllocator::stats();
+    printf("%-14s free %5zu pages, largest order %2u, fragmentation %u.%u%%\n", when,
+           pages.free_pages, pages.largest_free_order, st.fragmentation / 10, st.fragmentation % 10);
+}
+
+int main() {
+    void* region = aligned_alloc(PageAllocator::PAGE_SIZE, REGION_BYTES);
+    uintptr_t start = reinterpret_cast<uintptr_t>(region);
+    if (region == nullptr || !PageAllocator::init({start, start + REGION_BYTES})) {
+        printf("FAIL: init\n");
+        return 1;
+    }
+    PageAllocator::Stats fresh = PageAllocator::stats();
+    printf("region 32 MiB: %zu data pages\n", fresh.total_pages);
+    // Not zero even now: the page count is not a power of two
+    report_fragmentation("fresh");
+
+    std::mt19937 rng(12345);
+    std::vector<Live> live;
+    uint32_t tag = 1;
+
+    // Fill to ~75% of the pages
+    std::size_t target = fresh.total_pages * 3 / 4;
+    while (fresh.total_pages - PageAllocator::stats().free_pages < target) {
+        if (!allocate(live, rng, tag++)) break;
+    }
+    report_fragmentation("after fill");
+
+    // Churn around that occupancy
+    for (int step = 0; step < CHURN_STEPS; step++) {
+        bool can_free = !live.empty();
+        bool over = fresh.total_pages - PageAllocator::stats().free_pages > target;
+        if (can_free && (over || (rng() & 1))) {
+            release(live, rng() % live.size());
+        } else if (!allocate(live, rng, tag++) && can_free) {
+            release(live, rng() % live.size());
+        }
+    }
+    report_fragmentation("after churn");
+
+    report("alloc", s_alloc_ns);
+    report("free", s_free_ns);
+
+    while (!live.empty()) release(live, live.size() - 1);
+    report_fragmentation("after free");
+
+    PageAllocator::Stats end = PageAllocator::stats();
+    if (end.free_pages != fresh.free_pages || end.largest_free_order != fresh.largest_free_order) {
+        printf("FAIL: free pool not restored (%zu pages, order %u)\n", end.free_pages, end.largest_free_order);
+        s_failed = true;
+    }
+    return s_failed ? 1 : 0;
+}
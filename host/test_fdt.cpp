@@ -0,0 +1,372 @@
+/*
+ * micro32/host/test_fdt.cpp
+ *
+ * Device tree memory parsing against sample DTB blobs, and the boot path
+ * that reserves the firmware ranges before the page allocator lays out its
+ * metadata.
+ *
+ * Notes:
+ *  - The blobs are built in the test by DtbBuilder (header, memory
+ *    reservation block, structure block, strings block), so each case
+ *    states its tree in a few lines instead of shipping binary .dtb files.
+ *  - The sample board tree mirrors the Tab5 layout: a `memory@` node and a
+ *    device_type = "memory" node, a /reserved-memory child with `reg`, a
+ *    dynamically placed child without one, and a /memreserve/ entry.
+ *  - Every single-byte corruption of the sample, and the sample cut short
+ *    at every word, is parsed from an exactly sized heap copy; run under
+ *    -fsanitize=address to check the parser never reads past the blob.
+ */
+
+#include "fdt.h"
+#include "page_allocator.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+static bool s_failed = false;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failed = true;
+    }
+}
+
+// --- Blob builder ---
+
+class DtbBuilder {
+public:
+    void reserve(uint64_t base, uint64_t size) {
+        put64(m_rsv, base);
+        put64(m_rsv, size);
+    }
+
+    void begin(const char* name) {
+        put32(m_struct, FDT_BEGIN_NODE);
+        std::size_t len = strlen(name) + 1;
+        m_struct.insert(m_struct.end(), name, name + len);
+        pad(m_struct);
+    }
+
+    void end() { put32(m_struct, FDT_END_NODE); }
+
+    void prop(const char* name, const void* data, std::size_t len) {
+        put32(m_struct, FDT_PROP);
+        put32(m_struct, static_cast<uint32_t>(len));
+        put32(m_struct, string_offset(name));
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_struct.insert(m_struct.end(), bytes, bytes + len);
+        pad(m_struct);
+    }
+
+    void prop_string(const char* name, const char* value) { prop(name, value, strlen(value) + 1); }
+
+    void prop_cells(const char* name, std::initializer_list<uint32_t> cells) {
+        std::vector<uint8_t> data;
+        for (uint32_t c : cells) put32(data, c);
+        prop(name, data.data(), data.size());
+    }
+
+    std::vector<uint8_t> build() {
+        std::vector<uint8_t> rsv = m_rsv;
+        put64(rsv, 0);
+        put64(rsv, 0);
+        std::vector<uint8_t> structure = m_struct;
+        put32(structure, FDT_END);
+
+        uint32_t off_rsv = HEADER_BYTES;
+        uint32_t off_struct = off_rsv + static_cast<uint32_t>(rsv.size());
+        uint32_t off_strings = off_struct + static_cast<uint32_t>(structure.size());
+        uint32_t total = off_strings + static_cast<uint32_t>(m_strings.size());
+
+        std::vector<uint8_t> blob;
+        for (uint32_t v : {Fdt::MAGIC, total, off_struct, off_strings, off_rsv, 17u, 16u, 0u,
+                           static_cast<uint32_t>(m_strings.size()), static_cast<uint32_t>(structure.size())}) {
+            put32(blob, v);
+        }
+        blob.insert(blob.end(), rsv.begin(), rsv.end());
+        blob.insert(blob.end(), structure.begin(), structure.end());
+        blob.insert(blob.end(), m_strings.begin(), m_strings.end());
+        return blob;
+    }
+
+private:
+    static constexpr uint32_t FDT_BEGIN_NODE = 1;
+    static constexpr uint32_t FDT_END_NODE = 2;
+    static constexpr uint32_t FDT_PROP = 3;
+    static constexpr uint32_t FDT_END = 9;
+    static constexpr uint32_t HEADER_BYTES = 40;
+
+    static void put32(std::vector<uint8_t>& v, uint32_t x) {
+        for (int shift = 24; shift >= 0; shift -= 8) v.push_back(static_cast<uint8_t>(x >> shift));
+    }
+
+    static void put64(std::vector<uint8_t>& v, uint64_t x) {
+        put32(v, static_cast<uint32_t>(x >> 32));
+        put32(v, static_cast<uint32_t>(x));
+    }
+
+    static void pad(std::vector<uint8_t>& v) {
+        while (v.size() % 4) v.push_back(0);
+    }
+
+    // Property names are shared through the strings block
+    uint32_t string_offset(const char* name) {
+        for (std::size_t pos = 0; pos < m_strings.size(); pos += strlen(&m_strings[pos]) + 1) {
+            if (strcmp(&m_strings[pos], name) == 0) return static_cast<uint32_t>(pos);
+        }
+        uint32_t off = static_cast<uint32_t>(m_strings.size());
+        m_strings.insert(m_strings.end(), name, name + strlen(name) + 1);
+        return off;
+    }
+
+    std::vector<uint8_t> m_rsv;
+    std::vector<uint8_t> m_struct;
+    std::vector<char> m_strings;
+};
+
+// Split a 64-bit value into the two cells of a #*-cells = 2 property
+static uint32_t hi(uint64_t v) { return static_cast<uint32_t>(v >> 32); }
+static uint32_t lo(uint64_t v) { return static_cast<uint32_t>(v); }
+
+static std::vector<uint8_t> sample_board() {
+    DtbBuilder b;
+    b.reserve(0x48200000, 0x3000);
+    b.begin("");
+    b.prop_cells("#address-cells", {1});
+    b.prop_cells("#size-cells", {1});
+    b.prop_string("model", "tab5");
+    b.begin("cpus");
+    b.end();
+    b.begin("memory@48000000");
+    b.prop_cells("reg", {0x48000000, 0x2000000});
+    b.end();
+    b.begin("ram2");
+    b.prop_string("device_type", "memory");
+    b.prop_cells("reg", {0x4FF00000, 0xC0000});
+    b.end();
+    b.begin("reserved-memory");
+    b.prop_cells("#address-cells", {2});
+    b.prop_cells("#size-cells", {2});
+    b.prop("ranges", nullptr, 0);
+    b.begin("fw@48100000");
+    b.prop_cells("reg", {0, 0x48100000, 0, 0x10000});
+    b.end();
+    b.begin("pool");
+    b.prop_cells("size", {0, 0x1000});
+    b.end();
+    b.end();
+    b.end();
+    return b.build();
+}
+
+static bool has_range(const Fdt::Range* ranges, int count, uint64_t base, uint64_t size) {
+    for (int i = 0; i < count; i++) {
+        if (ranges[i].base == base && ranges[i].size == size) return true;
+    }
+    return false;
+}
+
+// --- Cases ---
+
+static void test_sample_board() {
+    std::vector<uint8_t> blob = sample_board();
+    Fdt::MemoryInfo info;
+    check(Fdt::valid(blob.data()), "sample: valid");
+    check(Fdt::total_size(blob.data()) == blob.size(), "sample: total_size");
+    check(Fdt::parse_memory(blob.data(), info), "sample: parse");
+    check(info.memory_count == 2, "sample: two memory ranges");
+    check(has_range(info.memory, info.memory_count, 0x48000000, 0x2000000), "sample: memory@ node");
+    check(has_range(info.memory, info.memory_count, 0x4FF00000, 0xC0000), "sample: device_type node");
+    check(info.reserved_count == 2, "sample: two reserved ranges (pool has no reg)");
+    check(has_range(info.reserved, info.reserved_count, 0x48100000, 0x10000), "sample: reserved-memory child");
+    check(has_range(info.reserved, info.reserved_count, 0x48200000, 0x3000), "sample: memreserve entry");
+    check(!info.truncated, "sample: not truncated");
+}
+
+static void test_64bit_cells() {
+    DtbBuilder b;
+    b.begin("");
+    b.prop_cells("#address-cells", {2});
+    b.prop_cells("#size-cells", {2});
+    b.begin("memory@100000000");
+    b.prop_cells("reg", {1, 0, 0, 0x40000000, 0, 0x80000000, 0, 0x1000});
+    b.end();
+    b.end();
+    std::vector<uint8_t> blob = b.build();
+
+    Fdt::MemoryInfo info;
+    check(Fdt::parse_memory(blob.data(), info), "64-bit: parse");
+    check(info.memory_count == 2, "64-bit: two ranges from one reg");
+    check(has_range(info.memory, info.memory_count, 0x100000000ull, 0x40000000), "64-bit: high range");
+    check(has_range(info.memory, info.memory_count, 0x80000000, 0x1000), "64-bit: low range");
+}
+
+static void test_truncated_lists() {
+    DtbBuilder b;
+    for (int i = 0; i < Fdt::MAX_RESERVED_RANGES + 2; i++) b.reserve(0x1000u * (i + 1), 0x100);
+    b.begin("");
+    b.prop_cells("#address-cells", {1});
+    b.prop_cells("#size-cells", {1});
+    b.begin("memory");
+    b.prop_cells("reg", {0x0, 0x1000, 0x10000, 0x1000, 0x20000, 0x1000, 0x30000, 0x1000, 0x40000, 0x1000});
+    b.end();
+    b.end();
+    std::vector<uint8_t> blob = b.build();
+
+    Fdt::MemoryInfo info;
+    check(Fdt::parse_memory(blob.data(), info), "overflow: parse");
+    check(info.memory_count == Fdt::MAX_MEMORY_RANGES, "overflow: memory list full");
+    check(info.reserved_count == Fdt::MAX_RESERVED_RANGES, "overflow: reserved list full");
+    check(info.truncated, "overflow: truncated flag");
+}
+
+static void test_rejected() {
+    Fdt::MemoryInfo info;
+
+    // A tree without memory is useless for the boot memory map
+    DtbBuilder b;
+    b.begin("");
+    b.prop_cells("#address-cells", {1});
+    b.prop_cells("#size-cells", {1});
+    b.begin("cpus");
+    b.end();
+    b.end();
+    std::vector<uint8_t> no_memory = b.build();
+    check(!Fdt::parse_memory(no_memory.data(), info), "reject: no memory node");
+
+    std::vector<uint8_t> bad_magic = sample_board();
+    bad_magic[0] ^= 0x01;
+    check(!Fdt::valid(bad_magic.data()), "reject: bad magic not valid");
+    check(Fdt::total_size(bad_magic.data()) == 0, "reject: bad magic has no size");
+    check(!Fdt::parse_memory(bad_magic.data(), info), "reject: bad magic");
+
+    // Structure block claimed to extend past totalsize
+    std::vector<uint8_t> bad_offset = sample_board();
+    bad_offset[8] = 0x7F;
+    check(!Fdt::parse_memory(bad_offset.data(), info), "reject: struct offset past the end");
+
+    // totalsize shorter than the header
+    std::vector<uint8_t> short_total = sample_board();
+    memset(&short_total[4], 0, 4);
+    short_total[7] = 16;
+    check(!Fdt::parse_memory(short_total.data(), info), "reject: totalsize below header");
+}
+
+// Parse from an exactly sized heap copy so out-of-bounds reads are caught
+static void parse_exact(const std::vector<uint8_t>& blob) {
+    uint8_t* copy = static_cast<uint8_t*>(malloc(blob.size()));
+    memcpy(copy, blob.data(), blob.size());
+    Fdt::MemoryInfo info;
+    Fdt::parse_memory(copy, info);
+    ::free(copy);
+}
+
+static void test_corruption() {
+    std::vector<uint8_t> blob = sample_board();
+    for (std::size_t i = 0; i < blob.size(); i++) {
+        std::vector<uint8_t> c = blob;
+        c[i] ^= 0xFF;
+        parse_exact(c);
+    }
+
+    // Cut the blob short and shrink totalsize to match
+    for (std::size_t len = 40; len < blob.size(); len += 4) {
+        std::vector<uint8_t> c(blob.begin(), blob.begin() + len);
+        c[4] = static_cast<uint8_t>(len >> 24);
+        c[5] = static_cast<uint8_t>(len >> 16);
+        c[6] = static_cast<uint8_t>(len >> 8);
+        c[7] = static_cast<uint8_t>(len);
+        parse_exact(c);
+    }
+}
+
+// Firmware ranges from the tree must stay untouched through
+// PageAllocator::init(), including one that overlaps where the metadata
+// would otherwise go, and must never be handed out
+static void test_early_reservations() {
+    constexpr std::size_t REGION_BYTES = 8u * 1024u * 1024u;
+    constexpr uint8_t POISON = 0xAB;
+    constexpr std::size_t PAGE = PageAllocator::PAGE_SIZE;
+
+    uint8_t* region = static_cast<uint8_t*>(aligned_alloc(PAGE, REGION_BYTES));
+    memset(region, POISON, REGION_BYTES);
+    uint64_t start = reinterpret_cast<uintptr_t>(region);
+
+    struct Firmware {
+        uint64_t offset;
+        uint64_t size;
+    };
+    const Firmware firmware[] = {
+        {100, 200},                // where the metadata would go
+        {3 * PAGE, PAGE},          // first data pages
+        {(4u << 20) + 10, 3 * PAGE},  // unaligned, in the middle
+    };
+
+    DtbBuilder b;
+    b.reserve(start + firmware[2].offset, firmware[2].size);
+    b.begin("");
+    b.prop_cells("#address-cells", {2});
+    b.prop_cells("#size-cells", {2});
+    b.begin("memory@0");
+    b.prop_cells("reg", {hi(start), lo(start), hi(REGION_BYTES), lo(REGION_BYTES)});
+    b.end();
+    b.begin("reserved-memory");
+    b.prop_cells("#address-cells", {2});
+    b.prop_cells("#size-cells", {2});
+    for (int i = 0; i < 2; i++) {
+        b.begin("fw");
+        b.prop_cells("reg", {hi(start + firmware[i].offset), lo(start + firmware[i].offset),
+                             hi(firmware[i].size), lo(firmware[i].size)});
+        b.end();
+    }
+    b.end();
+    b.end();
+    std::vector<uint8_t> blob = b.build();
+
+    // The kernel_main boot order: reservations first, then init
+    Fdt::MemoryInfo info;
+    check(Fdt::parse_memory(blob.data(), info) && info.reserved_count == 3, "boot: parse");
+    for (int i = 0; i < info.reserved_count; i++) {
+        PageAllocator::reserve_range(static_cast<uintptr_t>(info.reserved[i].base),
+                                     static_cast<std::size_t>(info.reserved[i].size));
+    }
+    check(PageAllocator::init({static_cast<uintptr_t>(info.memory[0].base),
+                               static_cast<uintptr_t>(info.memory[0].base + info.memory[0].size)}),
+          "boot: init");
+
+    bool untouched = true;
+    for (const Firmware& fw : firmware) {
+        for (uint64_t i = 0; i < fw.size; i++) {
+            if (region[fw.offset + i] != POISON) untouched = false;
+        }
+    }
+    check(untouched, "boot: firmware ranges untouched by init");
+
+    bool overlap = false;
+    std::size_t pages = 0;
+    while (void* p = PageAllocator::alloc_pages(0, PageAllocator::Fill::Dirty)) {
+        uint64_t off = reinterpret_cast<uintptr_t>(p) - start;
+        for (const Firmware& fw : firmware) {
+            if (off < fw.offset + fw.size && fw.offset < off + PAGE) overlap = true;
+        }
+        pages++;
+    }
+    check(!overlap, "boot: no page handed out over a firmware range");
+    check(pages > 0, "boot: pages left to allocate");
+    printf("early reservations: %zu pages allocatable\n", pages);
+}
+
+int main() {
+    test_sample_board();
+    test_64bit_cells();
+    test_truncated_lists();
+    test_rejected();
+    test_corruption();
+    test_early_reservations();
+    if (!s_failed) printf("fdt: all cases passed\n");
+    return s_failed ? 1 : 0;
+}
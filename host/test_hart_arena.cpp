@@ -0,0 +1,152 @@
+/*
+ * micro32/host/test_hart_arena.cpp
+ *
+ * Two-hart stress test of the per-hart arenas, with one thread per hart.
+ *
+ * Notes:
+ *  - Each thread binds itself to a hart with set_host_hart() and passes
+ *    objects to the other through a table of mailbox slots, so about half
+ *    of all frees are remote and go through the owner's remote-free stack.
+ *  - Every object carries its owner and a sequence number in its first and
+ *    last word. The request size is derived from that tag, so the check on
+ *    free looks at the last word of the size actually requested; a
+ *    mismatch means two live objects overlapped.
+ *  - After both threads stop, the objects left in the mailboxes are freed
+ *    on their owning hart, and every arena must balance: allocs equal
+ *    local plus remote frees, and no more remote frees drained than made.
+ *  - Build with -fsanitize=thread to check the remote-free path for races.
+ */
+
+#include "hart_arena.h"
+#include "page_allocator.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+constexpr std::size_t REGION_BYTES = 8u * 1024u * 1024u;
+constexpr std::size_t ARENA_BYTES = 1024u * 1024u;
+constexpr int STEPS = 1000000;
+constexpr unsigned SLOTS = 256;
+constexpr int YIELD_EVERY = 64;
+
+// mailbox[h] holds objects posted to hart h by the other one
+static std::atomic<void*> s_mailbox[HartArena::MAX_HARTS][SLOTS];
+static std::atomic<bool> s_failed(false);
+static std::atomic<int> s_started(0);
+
+static uint32_t tag(int hart, uint32_t seq) {
+    return (static_cast<uint32_t>(hart) << 28) | (seq & 0x0FFFFFFFu);
+}
+
+static int tag_owner(uint32_t t) {
+    return static_cast<int>(t >> 28);
+}
+
+// The request size follows from the tag, so whoever frees an object knows
+// how large it was asked to be without trusting anything stored in it
+static std::size_t request_size(uint32_t t) {
+    uint32_t h = t * 2654435761u;
+    std::size_t size = HartArena::MIN_SIZE + (h >> 8) % (HartArena::MAX_SIZE - HartArena::MIN_SIZE);
+    return size & ~(sizeof(uint32_t) - 1);
+}
+
+static uint32_t* last_word(void* p, std::size_t size) {
+    return static_cast<uint32_t*>(p) + size / sizeof(uint32_t) - 1;
+}
+
+static void stamp(void* p, uint32_t t) {
+    *static_cast<uint32_t*>(p) = t;
+    *last_word(p, request_size(t)) = t;
+}
+
+static bool intact(void* p, int expected_owner) {
+    uint32_t t = *static_cast<uint32_t*>(p);
+    return tag_owner(t) == expected_owner && *last_word(p, request_size(t)) == t;
+}
+
+static void check_and_free(void* p, int owner) {
+    if (!intact(p, owner)) {
+        printf("FAIL: object %p from hart %d overwritten\n", p, owner);
+        s_failed = true;
+    }
+    HartArena::free(p);
+}
+
+static void worker(int hart) {
+    HartArena::set_host_hart(hart);
+    int peer = 1 - hart;
+    uint32_t rng = 7u * static_cast<uint32_t>(hart) + 1u;
+
+    // Start together so the two harts actually overlap
+    s_started++;
+    while (s_started < HartArena::MAX_HARTS) std::this_thread::yield();
+
+    for (int step = 0; step < STEPS && !s_failed; step++) {
+        rng = rng * 1103515245u + 12345u;
+        unsigned slot = (rng >> 8) % SLOTS;
+
+        // Objects posted to us belong to the peer: a remote free
+        void* in = s_mailbox[hart][slot].exchange(nullptr);
+        if (in != nullptr) check_and_free(in, peer);
+
+        uint32_t t = tag(hart, static_cast<uint32_t>(step));
+        void* p = HartArena::alloc(request_size(t));
+        if (p == nullptr) {
+            printf("FAIL: hart %d arena exhausted at step %d\n", hart, step);
+            s_failed = true;
+            break;
+        }
+        stamp(p, t);
+
+        // An object the peer never took is still ours: a local free
+        void* old = s_mailbox[peer][slot].exchange(p);
+        if (old != nullptr) check_and_free(old, hart);
+
+        // On a single host CPU the threads would otherwise run in long
+        // time slices and rarely see each other's objects
+        if (step % YIELD_EVERY == 0) std::this_thread::yield();
+    }
+}
+
+int main() {
+    alignas(PageAllocator::PAGE_SIZE) static uint8_t region[REGION_BYTES];
+    uintptr_t start = reinterpret_cast<uintptr_t>(region);
+    if (!PageAllocator::init({start, start + REGION_BYTES}) || !HartArena::init(2, ARENA_BYTES)) {
+        printf("FAIL: init\n");
+        return 1;
+    }
+
+    std::thread h0(worker, 0);
+    std::thread h1(worker, 1);
+    h0.join();
+    h1.join();
+
+    // Drain the mailboxes, freeing each object on the hart that owns it
+    for (int h = 0; h < HartArena::MAX_HARTS; h++) {
+        for (unsigned slot = 0; slot < SLOTS; slot++) {
+            void* p = s_mailbox[h][slot].exchange(nullptr);
+            if (p == nullptr) continue;
+            int owner = tag_owner(*static_cast<uint32_t*>(p));
+            HartArena::set_host_hart(owner);
+            check_and_free(p, 1 - h);
+        }
+    }
+
+    for (int h = 0; h < HartArena::MAX_HARTS; h++) {
+        HartArena::Stats st = HartArena::stats(h);
+        printf("hart %d: allocs %llu local %llu remote %u drained %llu pages %zu/%zu\n", h,
+               static_cast<unsigned long long>(st.allocs), static_cast<unsigned long long>(st.local_frees),
+               st.remote_frees, static_cast<unsigned long long>(st.drained), st.pages_used, st.pages_total);
+        if (st.allocs != st.local_frees + st.remote_frees || st.drained > st.remote_frees) {
+            printf("FAIL: hart %d counters do not balance\n", h);
+            s_failed = true;
+        }
+        if (st.remote_frees == 0) {
+            printf("FAIL: hart %d saw no remote frees\n", h);
+            s_failed = true;
+        }
+    }
+    return s_failed ? 1 : 0;
+}
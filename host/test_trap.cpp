@@ -0,0 +1,173 @@
+/*
+ * micro32/host/test_trap.cpp
+ *
+ * Interrupt dispatch on the host CSR model: priorities, nesting, masking
+ * and the statistics, driven through Trap::Mock::raise().
+ *
+ * Notes:
+ *  - Lines: LOW (priority 1) < MID and MID_PEER (priority 3) < HIGH
+ *    (priority 6). The MID handler raises the others from inside itself,
+ *    so what gets delivered there shows which lines its mask covers.
+ *  - raise() sets mepc to epc_for(irq) on entry and performs mret from the
+ *    mstatus the dispatcher leaves, so a nested trap that is not undone
+ *    shows up as a wrong mepc or MIE after the outer one returns.
+ */
+
+#include "trap.h"
+#include <cstdint>
+#include <cstdio>
+
+constexpr unsigned LOW = Trap::IRQ_PLATFORM + 0;
+constexpr unsigned MID = Trap::IRQ_PLATFORM + 1;
+constexpr unsigned MID_PEER = Trap::IRQ_PLATFORM + 2;
+constexpr unsigned HIGH = Trap::IRQ_PLATFORM + 3;
+constexpr unsigned UNHANDLED = Trap::IRQ_PLATFORM + 4;
+
+constexpr uint32_t MSTATUS_MIE = 1u << 3;
+
+static bool s_failed = false;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        s_failed = true;
+    }
+}
+
+// Handler invocations in order, by line
+static unsigned s_log[16];
+static int s_log_count = 0;
+
+static void log_irq(void* context) {
+    if (s_log_count < 16) s_log[s_log_count++] = *static_cast<const unsigned*>(context);
+}
+
+// What the MID handler saw when it raised the other lines
+struct MidProbe {
+    bool enabled_inside;     // mstatus.MIE set while the handler runs
+    bool high_delivered;
+    bool peer_delivered;
+    bool low_delivered;
+    bool disable_peer;       // disable MID_PEER from inside the handler
+};
+
+static MidProbe s_mid;
+
+static void mid_handler(void* context) {
+    log_irq(context);
+    s_mid.enabled_inside = (Trap::Mock::mstatus() & MSTATUS_MIE) != 0;
+    s_mid.high_delivered = Trap::Mock::raise(HIGH);
+    s_mid.peer_delivered = Trap::Mock::raise(MID_PEER);
+    s_mid.low_delivered = Trap::Mock::raise(LOW);
+    if (s_mid.disable_peer) Trap::disable(MID_PEER);
+}
+
+// Handler contexts: the line number to log
+static unsigned s_low_id = LOW;
+static unsigned s_mid_id = MID;
+static unsigned s_peer_id = MID_PEER;
+static unsigned s_high_id = HIGH;
+
+static void test_registration() {
+    Trap::init();
+    check(Trap::register_handler(LOW, log_irq, &s_low_id, 1), "register LOW");
+    check(Trap::register_handler(MID, mid_handler, &s_mid_id, 3), "register MID");
+    check(Trap::register_handler(MID_PEER, log_irq, &s_peer_id, 3), "register MID_PEER");
+    check(Trap::register_handler(HIGH, log_irq, &s_high_id, 6), "register HIGH");
+
+    check(!Trap::register_handler(LOW, log_irq, nullptr, 1), "reject: line taken");
+    check(!Trap::register_handler(Trap::MAX_IRQS, log_irq, nullptr, 1), "reject: line out of range");
+    check(!Trap::register_handler(UNHANDLED, log_irq, nullptr, Trap::MAX_PRIORITY + 1), "reject: priority");
+    check(!Trap::register_handler(UNHANDLED, nullptr, nullptr, 1), "reject: no handler");
+
+    // Registered lines stay masked until enabled
+    check(!Trap::Mock::raise(LOW), "registered line masked until enable()");
+    Trap::enable(LOW);
+    Trap::enable(MID);
+    Trap::enable(MID_PEER);
+    Trap::enable(HIGH);
+}
+
+static void test_priorities() {
+    s_log_count = 0;
+    s_mid = MidProbe{};
+
+    check(Trap::Mock::raise(MID), "MID delivered");
+    check(s_mid.enabled_inside, "handlers run with interrupts enabled");
+    check(s_mid.high_delivered, "higher priority preempts");
+    check(!s_mid.peer_delivered, "equal priority masked while MID runs");
+    check(!s_mid.low_delivered, "lower priority masked while MID runs");
+    check(s_log_count == 2 && s_log[0] == MID && s_log[1] == HIGH, "order MID, HIGH");
+    check(Trap::max_depth() == 2, "max_depth 2 after one nested trap");
+
+    // Everything MID masked is back, and the outer trap returns correctly
+    check(Trap::Mock::mepc() == Trap::Mock::epc_for(MID), "mepc restored after nesting");
+    check((Trap::Mock::mstatus() & MSTATUS_MIE) != 0, "MIE set again after mret");
+    s_log_count = 0;
+    check(Trap::Mock::raise(MID_PEER) && Trap::Mock::raise(LOW), "masked lines restored");
+    check(s_log_count == 2 && s_log[0] == MID_PEER && s_log[1] == LOW, "order MID_PEER, LOW");
+
+    // A line disabled while it was masked stays off
+    s_mid = MidProbe{};
+    s_mid.disable_peer = true;
+    check(Trap::Mock::raise(MID), "MID delivered again");
+    check(!Trap::Mock::raise(MID_PEER), "line disabled inside a handler not re-enabled");
+    Trap::enable(MID_PEER);
+    check(Trap::Mock::raise(MID_PEER), "line enabled again");
+
+    // Critical sections block everything
+    uint32_t state = Trap::disable_interrupts();
+    check(!Trap::Mock::raise(HIGH), "no delivery with interrupts disabled");
+    Trap::restore_interrupts(state);
+    check(Trap::Mock::raise(HIGH), "delivery after restore_interrupts");
+}
+
+static void test_spurious() {
+    uint32_t before = Trap::spurious();
+    Trap::enable(UNHANDLED);
+    check(Trap::Mock::raise(UNHANDLED), "unhandled line delivered once");
+    check(Trap::spurious() == before + 1, "spurious counted");
+    check(!Trap::Mock::raise(UNHANDLED), "unhandled line masked afterwards");
+}
+
+static void test_stats() {
+    // MID: two raises; HIGH: nested once per MID, plus one direct raise
+    Trap::Stats mid = Trap::stats(MID);
+    Trap::Stats high = Trap::stats(HIGH);
+    check(mid.count == 2, "MID count");
+    check(high.count == 3, "HIGH count");
+    check(mid.min_cycles <= mid.max_cycles, "MID min <= max");
+    check(mid.total_cycles >= static_cast<uint64_t>(mid.min_cycles) * mid.count &&
+          mid.total_cycles <= static_cast<uint64_t>(mid.max_cycles) * mid.count, "MID total within min/max");
+
+    Trap::Stats none = Trap::stats(UNHANDLED);
+    check(none.count == 0 && none.min_cycles == 0, "no stats for a line without handler");
+    Trap::Stats out = Trap::stats(Trap::MAX_IRQS);
+    check(out.count == 0 && out.max_cycles == 0, "no stats out of range");
+
+    printf("latency MID: n=%u min %u max %u mean %llu cycles\n", mid.count, mid.min_cycles, mid.max_cycles,
+           static_cast<unsigned long long>(mid.total_cycles / mid.count));
+    printf("max depth %u, spurious %u\n", Trap::max_depth(), Trap::spurious());
+}
+
+static void test_unregister() {
+    Trap::unregister_handler(HIGH);
+    check(!Trap::Mock::raise(HIGH), "unregistered line masked");
+    check(Trap::register_handler(HIGH, log_irq, &s_high_id, 0), "line free again");
+
+    // HIGH now has the lowest priority, so MID masks it
+    Trap::enable(HIGH);
+    s_mid = MidProbe{};
+    check(Trap::Mock::raise(MID), "MID after re-registration");
+    check(!s_mid.high_delivered, "masks rebuilt after re-registration");
+}
+
+int main() {
+    test_registration();
+    test_priorities();
+    test_spurious();
+    test_stats();
+    test_unregister();
+    if (!s_failed) printf("trap: all cases passed\n");
+    return s_failed ? 1 : 0;
+}
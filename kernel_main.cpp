@@ -1,6 +1,16 @@
 
 #include "drivers/lcd.h"
+#include "memory_manager.h"
+#include "page_allocator.h"
+#include "heap.h"
+#include "memory_map.h"
+#include "fdt.h"
+#include "boot_log.h"
+#include "text_format.h"
+#include "timer.h"
+#include "trap.h"
 #include <cstdint>
+#include <cstddef>
 
 namespace LCDDriver {
     void Print(const char* str, int x, int y, uint16_t color);
@@ -9,13 +19,164 @@ namespace LCDDriver {
 
 namespace lcd = LCDDriver;
 
-extern "C" void kernel_main() {
-    uint32_t a1_value = 0;
+// Kernel heap size as a page order (2^8 pages = 1 MiB)
+constexpr unsigned KERNEL_HEAP_ORDER = 8;
 
-    // Inline assembly to read the value of the a1
-    asm volatile("mv %0, a1" : "=r"(a1_value));
+// Free pages pre-zeroed per idle loop iteration
+constexpr std::size_t IDLE_ZERO_PAGES = 4;
 
-    lcd::initialize();
+// RAM windows a boot loader may place the device tree in. Replace with the
+// actual ones for your board (SRAM matches micro32.ld; PSRAM is the window
+// the MemoryManager probe covers).
+constexpr uintptr_t SRAM_WINDOW_BASE = 0x4FF00000u;
+constexpr std::size_t SRAM_WINDOW_SIZE = 768u * 1024u;
+constexpr uintptr_t PSRAM_WINDOW_BASE = MemoryManager::DEFAULT_RAM_BASE;
+constexpr std::size_t PSRAM_WINDOW_SIZE = MemoryManager::PROBE_MAX_SIZE;
+
+// Smallest blob Fdt::valid() reads: the v17 header
+constexpr std::size_t FDT_HEADER_BYTES = 40;
+
+static bool in_window(uintptr_t start, std::size_t bytes, uintptr_t base, std::size_t size) {
+    return start >= base && start - base <= size && bytes <= size - (start - base);
+}
+
+static bool in_ram(uintptr_t start, std::size_t bytes) {
+    return in_window(start, bytes, SRAM_WINDOW_BASE, SRAM_WINDOW_SIZE) ||
+           in_window(start, bytes, PSRAM_WINDOW_BASE, PSRAM_WINDOW_SIZE);
+}
+
+// The boot path does not promise a device tree in a1. Only dereference a
+// pointer that is aligned and lies, with the whole blob, inside known RAM;
+// anything else would fault before the kernel can report it.
+static const void* checked_dtb(const void* dtb) {
+    uintptr_t p = reinterpret_cast<uintptr_t>(dtb);
+    if (p == 0 || (p & 7) != 0 || !in_ram(p, FDT_HEADER_BYTES)) return nullptr;
+    uint32_t total = Fdt::total_size(dtb);
+    if (total == 0 || !in_ram(p, total)) return nullptr;
+    return dtb;
+}
+
+// Register the part of [start, end) not covered by a firmware reservation,
+// splitting around each reservation that overlaps it
+static void add_dt_psram(uintptr_t start, uintptr_t end, const Fdt::MemoryInfo& info) {
+    if (start >= end) return;
+    for (int i = 0; i < info.reserved_count; i++) {
+        const Fdt::Range& r = info.reserved[i];
+        if (r.base >= end || r.base + r.size <= start) continue;
+        add_dt_psram(start, static_cast<uintptr_t>(r.base), info);
+        if (r.base + r.size < end) add_dt_psram(static_cast<uintptr_t>(r.base + r.size), end, info);
+        return;
+    }
+    MemoryMap::add_region("dt-memory", MemoryMap::Kind::Psram, start, end - start,
+                          MemoryMap::ATTR_DMA | MemoryMap::ATTR_CACHED, MemoryMap::PSRAM_LATENCY);
+}
+
+// Use the device tree memory map: the largest /memory range becomes the
+// MemoryManager RAM. Other ranges inside the PSRAM window are registered
+// with the region table minus the firmware reservations; ranges elsewhere
+// are of unknown kind and left alone. Returns false if `blob` is not a
+// usable device tree.
+static bool configure_ram_from_fdt(const void* blob, Fdt::MemoryInfo& info) {
+    if (blob == nullptr || !Fdt::parse_memory(blob, info)) return false;
+
+    int main_range = -1;
+    for (int i = 0; i < info.memory_count; i++) {
+        const Fdt::Range& r = info.memory[i];
+        if (r.base + r.size > UINTPTR_MAX) continue;  // not addressable
+        if (main_range < 0 || r.size > info.memory[main_range].size) main_range = i;
+    }
+    if (main_range < 0) return false;
+
+    MemoryManager::set_ram_bounds(static_cast<uintptr_t>(info.memory[main_range].base),
+                                  static_cast<std::size_t>(info.memory[main_range].size));
+
+    for (int i = 0; i < info.memory_count; i++) {
+        const Fdt::Range& r = info.memory[i];
+        if (i == main_range || r.base + r.size > UINTPTR_MAX) continue;
+        uintptr_t start = static_cast<uintptr_t>(r.base);
+        std::size_t size = static_cast<std::size_t>(r.size);
+        if (!in_window(start, size, PSRAM_WINDOW_BASE, PSRAM_WINDOW_SIZE)) continue;
+        add_dt_psram(start, start + size, info);
+    }
+    return true;
+}
+
+// Keep firmware-reserved ranges out of the page pool. Runs before
+// PageAllocator::init so its metadata is laid out around them.
+static void apply_fdt_reservations(const Fdt::MemoryInfo& info) {
+    for (int i = 0; i < info.reserved_count; i++) {
+        const Fdt::Range& r = info.reserved[i];
+        if (r.base + r.size > UINTPTR_MAX) continue;
+        PageAllocator::reserve_range(static_cast<uintptr_t>(r.base),
+                                     static_cast<std::size_t>(r.size));
+    }
+}
+
+// Boot log lines go below the greeting, one text row each
+static int s_boot_log_y = 72;
+
+static void print_boot_log_line(const char* line) {
+    lcd::Print(line, 0, s_boot_log_y, 0xFFFF);
+    s_boot_log_y += lcd::GLYPH_HEIGHT;
+}
+
+// The PSRAM size probe, when the RAM size came from it rather than the
+// device tree or the linker script
+static void print_probe_line() {
+    MemoryManager::ProbeResult probe = MemoryManager::last_probe();
+    if (!probe.valid) return;
+    TextFormat::Line line;
+    line.clear();
+    line.add("psram ");
+    line.add(static_cast<uint64_t>(probe.size >> 20));
+    line.add(" MiB in ");
+    line.add(Timer::cycles_to_us(probe.cycles));
+    line.add("us");
+    print_boot_log_line(line.text);
+}
+
+// Entered from startup.s with the boot loader's a0 (hart id) and a1
+// (device tree pointer, if any). Only the boot hart gets here.
+extern "C" void kernel_main(uint32_t hartid, const void* dtb) {
+    static_cast<void>(hartid);
+    uint32_t a1_value = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(dtb));
+    BootLog::mark("kernel");
+
+    // Vectored traps first, so faults during bring-up are caught
+    Trap::init();
+
+    // Start the panel reset now and advance its init between the boot
+    // stages below, so its waits overlap memory setup instead of stalling
+    lcd::initStart();
+
+    Fdt::MemoryInfo dt_memory;
+    bool have_dt = configure_ram_from_fdt(checked_dtb(dtb), dt_memory);
+
+    lcd::initPoll();
+
+    MemoryManager::reserve_all_except_first_8kb();
+    lcd::initPoll();
+    if (have_dt) apply_fdt_reservations(dt_memory);
+    PageAllocator::init(MemoryManager::get_usable_region());
+    lcd::initPoll();
+    // The heap never assumes zeroed memory (calloc clears its own blocks).
+    // Without the pages the kernel runs on without a heap: allocs fail.
+    void* heap_pool = PageAllocator::alloc_pages(KERNEL_HEAP_ORDER, PageAllocator::Fill::Dirty);
+    if (heap_pool != nullptr) {
+        Heap::init(heap_pool, PageAllocator::PAGE_SIZE << KERNEL_HEAP_ORDER);
+    }
+    BootLog::mark("memory");
+    lcd::initPoll();
+
+    // Measure the real CPU clock so cycle counts convert to accurate times
+    Timer::calibrate();
+
+    // Spend whatever panel wait is left pre-zeroing pages
+    while (!lcd::initPoll()) {
+        PageAllocator::idle_zero(IDLE_ZERO_PAGES);
+    }
+    BootLog::mark("lcd");
+    lcd::enableFramebuffer();  // Falls back to direct drawing if this fails
     lcd::clearScreen(0x0000);  // Black background
 
     lcd::Print("Hello, World!", 0, 0, 0xFFFF);
@@ -34,8 +195,23 @@ extern "C" void kernel_main() {
 
     lcd::Print("a1 register:", 0, 32, 0xFFFF);
     lcd::Print(hex_buffer, 0, 48, 0xFFFF);
+    lcd::flush();
+    BootLog::mark("pixels");
+
+    BootLog::dump(print_boot_log_line);
+    print_probe_line();
+    lcd::flush();
 
     while (true) {
-        // infinite loop to keep kernel running
+        // Idle: pre-zero free pages so later zeroed allocations are cheap,
+        // then sleep once there is nothing left. Interrupts stay off around
+        // both: handlers may free pages, which must not happen while the
+        // free lists are walked, and an interrupt arriving between the check
+        // and wfi still wakes it (wfi ignores MIE) instead of being lost.
+        uint32_t irq_state = Trap::disable_interrupts();
+        if (PageAllocator::idle_zero(IDLE_ZERO_PAGES) == 0) {
+            Trap::wait_for_interrupt();
+        }
+        Trap::restore_interrupts(irq_state);
     }
 }
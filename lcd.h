@@ -7,28 +7,137 @@
 
 #include <cstdint>
 
+// Panel resolution; override from the build for other panels
+#ifndef MICRO32_LCD_WIDTH
+#define MICRO32_LCD_WIDTH 240
+#endif
+#ifndef MICRO32_LCD_HEIGHT
+#define MICRO32_LCD_HEIGHT 320
+#endif
+
 // Namespace for LCD driver functions
 namespace LCDDriver {
+    // Panel resolution in pixels (portrait orientation)
+    constexpr int LCD_WIDTH = MICRO32_LCD_WIDTH;
+    constexpr int LCD_HEIGHT = MICRO32_LCD_HEIGHT;
+
     // Function to send a command to the LCD
     void sendCommand(uint8_t cmd);
 
     // Function to send data to the LCD
     void sendData(uint8_t data);
 
-    // Function to initialize the LCD
+    // Function to initialize the LCD (blocks for the whole sequence)
     void initialize();
 
+    // Non-blocking initialization: initStart() begins the reset pulse and
+    // initPoll() sends every command whose wait has elapsed, returning true
+    // once the panel is up. The panel's mandatory waits (up to 120 ms) pass
+    // between polls, so the caller can do other boot work meanwhile.
+    void initStart();
+    bool initPoll();
+
+    // Program the controller address window to the inclusive rectangle
+    // (x0,y0)-(x1,y1) and start a memory write (RAMWR). Pixels streamed
+    // afterwards with writePixels/writeColor fill the window row by row.
+    void setWindow(int x0, int y0, int x1, int y1);
+
+    // Stream n RGB565 pixels into the window opened by setWindow
+    void writePixels(const uint16_t* pixels, int n);
+
+    // Stream the same RGB565 color n times into the window opened by setWindow
+    void writeColor(uint16_t color, int n);
+
+    // Fill a w x h rectangle at x,y with a single color (clipped to the panel).
+    // Large direct fills are queued on DMA from a small repeated pattern
+    // buffer and return while the pixels are on the wire.
+    void fillRect(int x, int y, int w, int h, uint16_t color);
+
+    // Allocate an off-screen RGB565 framebuffer from MemoryManager::carve()
+    // and redirect all drawing into it. Requires the memory reservation to
+    // have been made. Returns false if the buffer could not be allocated.
+    bool enableFramebuffer();
+
+    // Stop drawing into the framebuffer (pending changes are flushed first)
+    void disableFramebuffer();
+
+    // True while drawing goes to the framebuffer
+    bool framebufferEnabled();
+
+    // Queue the dirty rectangles of the framebuffer for transmission, one
+    // address window per rectangle, and return while DMA sends them.
+    // No-op when the framebuffer is disabled.
+    void flush();
+
+    // Block until the most recent flush() has been transmitted
+    void flushWait();
+
+    // Refresh signal present() aligns transmission to: the panel's tearing
+    // effect (TE) output, a fixed-rate timer standing in for it, or nothing
+    enum class SyncSource { None, TearingPin, Timer };
+
+    // Select the sync source; refresh_hz paces the Timer source
+    void setSyncSource(SyncSource source, uint32_t refresh_hz = 60);
+
+    // Add a second framebuffer so rendering of frame N+1 overlaps the
+    // transmission of frame N. Requires enableFramebuffer() first.
+    bool enableDoubleBuffer();
+
+    // Finish the current frame: swap buffers and start transmitting the
+    // finished one at the next sync point. Drawing continues immediately
+    // into the other buffer. Equivalent to flush() when single-buffered.
+    void present();
+
+    // Frame pacing statistics collected by present()
+    struct PresentStats {
+        uint32_t frames;           // frames presented since the last reset
+        float fps;                 // achieved frames per second
+        float overlap_ratio;       // share of transmission time the CPU kept rendering
+        uint64_t transfer_cycles;  // total cycles frames spent on the wire
+        uint64_t blocked_cycles;   // cycles present() waited for the previous frame
+        uint64_t sync_wait_cycles; // cycles present() waited for the sync point
+    };
+
+    PresentStats presentStats();
+    void resetPresentStats();
+
+    // Define the hardware vertical scrolling area (VSCRDEF, 0x33): lines fixed
+    // at the top and bottom of the panel; everything between scrolls
+    void setScrollArea(int top_fixed, int bottom_fixed);
+
+    // Set which frame memory line is shown first in the scrolling area
+    // (VSCRSADD, 0x37). Pending framebuffer transfers are drained first.
+    void setScrollStart(int line);
+
     // Function to draw a pixel on the LCD
     void drawPixel(int x, int y, uint16_t color);
 
     // Function to clear the screen
     void clearScreen(uint16_t color);
 
-    // Print a null-terminated string at x,y with 16-bit color
+    // Glyph cell size of the built-in 8x8 font
+    constexpr int GLYPH_WIDTH = 8;
+    constexpr int GLYPH_HEIGHT = 8;
+
+    // Print a null-terminated string at x,y with 16-bit color on black.
+    // The whole line is rendered into a buffer and sent in one window.
     void Print(const char* str, int x, int y, uint16_t color);
 
+    // Print a null-terminated string at x,y with foreground and background colors
+    void Print(const char* str, int x, int y, uint16_t color, uint16_t bg);
+
     // Print a signed integer at x,y with 16-bit color
     void Print(int number, int x, int y, uint16_t color);
+
+    // Counters of the (glyph, fg, bg) tile cache used by Print
+    struct GlyphCacheStats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+    };
+
+    GlyphCacheStats glyphCacheStats();
+    void resetGlyphCacheStats();
 }
 
 #endif // LCD_DRIVER_H
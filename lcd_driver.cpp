@@ -1,81 +1,355 @@
 
 
 #include <cstdint>
-#include <cstdio>
+#include "lcd.h"
+#include "lcd_internal.h"
+#include "cache.h"
+#include "dma.h"
+#include "mmio.h"
+#include "timer.h"
 
 // Define memory-mapped registers for SPI and GPIO
 #define SPI_BASE 0x60002000  // Replace with the actual SPI base address
 #define SPI_CMD_REG (SPI_BASE + 0x00)
+#define SPI_STATUS_REG (SPI_BASE + 0x04)    // bit 1: TX FIFO full
 #define SPI_DATA_REG (SPI_BASE + 0x08)
+#define SPI_FIFO_REG (SPI_BASE + 0x0C)      // 32-bit TX FIFO, sent LSB byte first
+#define SPI_DMA_CONF_REG (SPI_BASE + 0x30)  // bit 0: transmit from DMA
+#define SPI_DMA_LEN_REG (SPI_BASE + 0x34)   // bytes to transmit from DMA
 #define GPIO_BASE 0x60004000 // Replace with the actual GPIO base address
 #define GPIO_OUT_REG (GPIO_BASE + 0x04)
+#define GPIO_IN_REG (GPIO_BASE + 0x3C)
+#define LCD_TE_PIN 6                 // Replace with the GPIO wired to the panel TE output
+#define LCD_RESET_PIN 5
 
 // LCD Driver namespace
 namespace LCDDriver {
 
     // Function to send a command to the LCD
     void sendCommand(uint8_t cmd) {
-        *(volatile uint32_t*)SPI_CMD_REG = 0;  // Set to command mode
-        *(volatile uint32_t*)SPI_DATA_REG = cmd;
-        while (*(volatile uint32_t*)SPI_CMD_REG & (1 << 0));  // Wait for transmission to complete
+        Mmio::write32(SPI_CMD_REG, 0);  // Set to command mode
+        Mmio::write32(SPI_DATA_REG, cmd);
+        while (Mmio::read32(SPI_CMD_REG) & (1 << 0));  // Wait for transmission to complete
     }
 
     // Function to send data to the LCD
     void sendData(uint8_t data) {
-        *(volatile uint32_t*)SPI_CMD_REG = 1;  // Set to data mode
-        *(volatile uint32_t*)SPI_DATA_REG = data;
-        while (*(volatile uint32_t*)SPI_CMD_REG & (1 << 0));  // Wait for transmission to complete
+        Mmio::write32(SPI_CMD_REG, 1);  // Set to data mode
+        Mmio::write32(SPI_DATA_REG, data);
+        while (Mmio::read32(SPI_CMD_REG) & (1 << 0));  // Wait for transmission to complete
+    }
+
+#ifdef MICRO32_HOST
+    // Describe the SPI block to the recording MMIO backend: data and FIFO
+    // writes put bytes on the wire and the transmitter never reports busy
+    static void describeHostModel() {
+        Mmio::Host::register_data_port(SPI_DATA_REG, 1);
+        Mmio::Host::register_data_port(SPI_FIFO_REG, 4);
+        Mmio::Host::set_read_value(SPI_CMD_REG, 0);
+        Mmio::Host::set_read_value(SPI_STATUS_REG, 0);
+    }
+#endif
+
+    // Panel timing from the controller datasheet
+    constexpr uint32_t RESET_PULSE_US = 10;       // minimum reset low time
+    constexpr uint32_t RESET_RECOVERY_US = 5000;  // reset release to first command
+
+    // One step of the init sequence: a command, its parameters, and the
+    // minimum time before the next command may be sent
+    struct InitStep {
+        uint8_t cmd;
+        uint8_t len;
+        uint8_t data[2];
+        uint32_t delay_us;
+    };
+
+    static const InitStep INIT_SEQUENCE[] = {
+        {0x01, 0, {0}, 120000},    // Software reset; 120 ms before sleep out
+        {0x11, 0, {0}, 5000},      // Exit sleep mode; 5 ms before the next command
+        {0x3A, 1, {0x55}, 0},      // Pixel format: 16-bit RGB565
+        {0x29, 0, {0}, 0},         // Turn on the display
+    };
+
+    constexpr int INIT_STEPS = sizeof(INIT_SEQUENCE) / sizeof(INIT_SEQUENCE[0]);
+
+    // Progress of the non-blocking init; each state waits for s_init_deadline
+    enum class InitState : uint8_t {
+        Idle,       // initStart() not called yet
+        ResetLow,   // reset pin held low
+        Sequence,   // sending INIT_SEQUENCE[s_init_step]
+        Done,
+    };
+
+    static InitState s_init_state = InitState::Idle;
+    static int s_init_step = 0;
+    static uint64_t s_init_deadline = 0;
+
+    // Function to start initializing the LCD
+    void initStart() {
+#ifdef MICRO32_HOST
+        describeHostModel();
+#endif
+
+        // Reset the LCD (toggle the reset pin)
+        Mmio::clear_bits(GPIO_OUT_REG, 1 << LCD_RESET_PIN);  // Reset pin low
+        s_init_deadline = Timer::deadline_us(RESET_PULSE_US);
+        s_init_state = InitState::ResetLow;
+    }
+
+    // Function to advance LCD initialization; true once it is complete
+    bool initPoll() {
+        while (true) {
+            if (s_init_state == InitState::Done) return true;
+            if (s_init_state == InitState::Idle) return false;
+            if (!Timer::reached(s_init_deadline)) return false;
+
+            if (s_init_state == InitState::ResetLow) {
+                Mmio::set_bits(GPIO_OUT_REG, 1 << LCD_RESET_PIN);  // Reset pin high
+                s_init_deadline = Timer::deadline_us(RESET_RECOVERY_US);
+                s_init_state = InitState::Sequence;
+                s_init_step = 0;
+                continue;
+            }
+
+            if (s_init_step == INIT_STEPS) {
+                Dma::init();
+                s_init_state = InitState::Done;
+                return true;
+            }
+
+            // Send the next command; its delay gates the one after it
+            const InitStep& step = INIT_SEQUENCE[s_init_step++];
+            sendCommand(step.cmd);
+            for (int i = 0; i < step.len; i++) {
+                sendData(step.data[i]);
+            }
+            s_init_deadline = Timer::deadline_us(step.delay_us);
+        }
     }
 
     // Function to initialize the LCD
     void initialize() {
-        // Reset the LCD (toggle the reset pin)
-        *(volatile uint32_t*)GPIO_OUT_REG &= ~(1 << 5);  // Set GPIO5 low (reset pin)
-        for (volatile int i = 0; i < 100000; i++);       // Delay
-        *(volatile uint32_t*)GPIO_OUT_REG |= (1 << 5);   // Set GPIO5 high
+        initStart();
+        while (!initPoll()) {
+            // Nothing else to do while the panel settles
+        }
+    }
 
-        // Send initialization commands
-        sendCommand(0x01);  // Software reset
-        for (volatile int i = 0; i < 120000; i++);       // Delay
-        sendCommand(0x11);  // Exit sleep mode
-        for (volatile int i = 0; i < 120000; i++);       // Delay
-        sendCommand(0x29);  // Turn on the display
+    // Send a 16-bit value as two data bytes, high byte first
+    static void sendData16(uint16_t value) {
+        sendData(value >> 8);
+        sendData(value & 0xFF);
     }
 
-    // Function to draw a pixel on the LCD
-    void drawPixel(int x, int y, uint16_t color) {
+    // Send CASET/RASET/RAMWR for the inclusive window (x0,y0)-(x1,y1)
+    static void programWindow(int x0, int y0, int x1, int y1) {
         sendCommand(0x2A);  // Set column address
-        sendData(x >> 8);
-        sendData(x & 0xFF);
+        sendData16(x0);
+        sendData16(x1);
         sendCommand(0x2B);  // Set row address
-        sendData(y >> 8);
-        sendData(y & 0xFF);
+        sendData16(y0);
+        sendData16(y1);
         sendCommand(0x2C);  // Write memory
-        sendData(color >> 8);
-        sendData(color & 0xFF);
     }
 
-    // Function to clear the screen
-    void clearScreen(uint16_t color) {
-        sendCommand(0x2C);  // Memory write
-        for (int i = 0; i < 240 * 320; i++) {  // Assuming 240x320 resolution
-            sendData(color >> 8);
-            sendData(color & 0xFF);
+    // Program the address window once and open a memory write burst.
+    // Queued DMA transfers are drained first so they cannot interleave.
+    void Panel::setWindow(int x0, int y0, int x1, int y1) {
+        Dma::wait_all();
+        programWindow(x0, y0, x1, y1);
+    }
+
+    // Program the window and hand the data phase to the DMA engine
+    void Panel::beginDmaWindow(int x0, int y0, int x1, int y1, uint32_t bytes) {
+        programWindow(x0, y0, x1, y1);
+        Mmio::write32(SPI_CMD_REG, 1);  // Set to data mode
+        Mmio::write32(SPI_DMA_LEN_REG, bytes);
+        Mmio::write32(SPI_DMA_CONF_REG, 1);  // Transmit from DMA
+    }
+
+    // Return the SPI transmitter to CPU-driven transfers
+    void Panel::endDma() {
+        Mmio::write32(SPI_DMA_CONF_REG, 0);
+    }
+
+    void Panel::enableTearingOutput() {
+        Dma::wait_all();
+        sendCommand(0x35);  // Tearing effect line on
+        sendData(0x00);     // V-blank information only
+    }
+
+    bool Panel::tearingLevel() {
+        return (Mmio::read32(GPIO_IN_REG) & (1 << LCD_TE_PIN)) != 0;
+    }
+
+    // Two pixels per FIFO word; the FIFO sends the low byte first
+    static inline uint32_t packPixels(uint16_t first, uint16_t second) {
+        return toWire(first) | (static_cast<uint32_t>(toWire(second)) << 16);
+    }
+
+    // Push one word into the TX FIFO, waiting only while it is full
+    static inline void pushFifo(uint32_t word) {
+        while (Mmio::read32(SPI_STATUS_REG) & (1 << 1));  // Wait for FIFO space
+        Mmio::write32(SPI_FIFO_REG, word);
+    }
+
+    // Wait until the FIFO has drained onto the wire
+    static inline void waitSpiIdle() {
+        while (Mmio::read32(SPI_CMD_REG) & (1 << 0));
+    }
+
+    // Stream RGB565 pixels into the current window, two per FIFO word
+    void Panel::writePixels(const uint16_t* pixels, int n) {
+        Mmio::write32(SPI_CMD_REG, 1);  // Set to data mode
+        int i = 0;
+        for (; i + 1 < n; i += 2) {
+            pushFifo(packPixels(pixels[i], pixels[i + 1]));
         }
+        waitSpiIdle();
+        if (i < n) sendData16(pixels[i]);
     }
-    // Function to print a string or integer to the LCD
-    void Print(const char* str, int x, int y, uint16_t color) {
-        int offset = 0;
-        while (*str) {
-            drawPixel(x + offset, y, color);  // Draw each character
-            offset += 8;  // Move to the next character position
-            str++;
+
+    // Stream a repeated RGB565 color into the current window, two per FIFO word
+    void Panel::writeColor(uint16_t color, int n) {
+        Mmio::write32(SPI_CMD_REG, 1);  // Set to data mode
+        uint32_t word = packPixels(color, color);
+        for (int pairs = n / 2; pairs > 0; pairs--) {
+            pushFifo(word);
         }
+        waitSpiIdle();
+        if (n & 1) sendData16(color);
     }
 
-    void Print(int number, int x, int y, uint16_t color) {
-        char buffer[12];  // Buffer to hold the integer as a string
-        snprintf(buffer, sizeof(buffer), "%d", number);  // Convert integer to string
-        Print(buffer, x, y, color);  // Reuse the string Print function
+    // DMA fills stream the same small pattern buffer through every descriptor
+    constexpr int FILL_PATTERN_PIXELS = 1024;
+    constexpr int FILL_PATTERN_BYTES = FILL_PATTERN_PIXELS * 2;
+    constexpr int MAX_FILL_DESCRIPTORS = (LCD_WIDTH * LCD_HEIGHT + FILL_PATTERN_PIXELS - 1) / FILL_PATTERN_PIXELS;
+
+    // Fills smaller than this go through the FIFO; DMA setup is not worth it
+    constexpr int FILL_DMA_MIN_PIXELS = 2048;
+
+    struct FillJob {
+        int x0, y0, x1, y1;
+        uint32_t bytes;
+    };
+
+    static uint32_t s_fill_pattern[FILL_PATTERN_PIXELS / 2];
+    static Dma::Descriptor s_fill_desc[MAX_FILL_DESCRIPTORS];
+    static FillJob s_fill_job;
+    static Dma::Handle s_fill_handle = 0;
+
+    static void fillJobStart(void* context) {
+        const FillJob* job = static_cast<const FillJob*>(context);
+        Panel::beginDmaWindow(job->x0, job->y0, job->x1, job->y1, job->bytes);
+    }
+
+    static void fillJobComplete(void*) {
+        Panel::endDma();
+    }
+
+    // Queue a solid fill of the inclusive window on the DMA engine
+    static void fillDma(int x0, int y0, int x1, int y1, uint16_t color) {
+        // The pattern buffer and descriptors belong to the previous fill until it is out
+        Dma::wait(s_fill_handle);
+
+        uint32_t word = packPixels(color, color);
+        for (int i = 0; i < FILL_PATTERN_PIXELS / 2; i++) {
+            s_fill_pattern[i] = word;
+        }
+
+        uint32_t bytes = static_cast<uint32_t>(x1 - x0 + 1) * (y1 - y0 + 1) * 2;
+        uint32_t remaining = bytes;
+        int count = 0;
+        while (remaining > 0) {
+            uint32_t len = remaining < static_cast<uint32_t>(FILL_PATTERN_BYTES) ? remaining : FILL_PATTERN_BYTES;
+            remaining -= len;
+            Dma::make_descriptor(s_fill_desc[count], s_fill_pattern, len, &s_fill_desc[count + 1], remaining == 0);
+            count++;
+        }
+
+        // The engine does not snoop the data cache
+        Cache::writeback(s_fill_pattern, sizeof(s_fill_pattern));
+        Cache::writeback(s_fill_desc, count * sizeof(Dma::Descriptor));
+
+        s_fill_job = FillJob{x0, y0, x1, y1, bytes};
+
+        Dma::Transfer t;
+        t.chain = s_fill_desc;
+        t.on_start = fillJobStart;
+        t.on_complete = fillJobComplete;
+        t.context = &s_fill_job;
+        s_fill_handle = Dma::submit(t);
+    }
+
+    // Window/stream calls go to the framebuffer when it is enabled,
+    // otherwise straight to the panel
+    void setWindow(int x0, int y0, int x1, int y1) {
+        if (Framebuffer::active()) {
+            Framebuffer::setWindow(x0, y0, x1, y1);
+        } else {
+            Panel::setWindow(x0, y0, x1, y1);
+        }
+    }
+
+    void writePixels(const uint16_t* pixels, int n) {
+        if (Framebuffer::active()) {
+            Framebuffer::writePixels(pixels, n);
+        } else {
+            Panel::writePixels(pixels, n);
+        }
+    }
+
+    void writeColor(uint16_t color, int n) {
+        if (Framebuffer::active()) {
+            Framebuffer::writeColor(color, n);
+        } else {
+            Panel::writeColor(color, n);
+        }
+    }
+
+    // Function to fill a rectangle with one window setup and one RAMWR burst
+    void fillRect(int x, int y, int w, int h, uint16_t color) {
+        // Clip to the panel
+        if (x < 0) { w += x; x = 0; }
+        if (y < 0) { h += y; y = 0; }
+        if (x + w > LCD_WIDTH) w = LCD_WIDTH - x;
+        if (y + h > LCD_HEIGHT) h = LCD_HEIGHT - y;
+        if (w <= 0 || h <= 0) return;
+
+        // Without cache maintenance the DMA engine could read a stale
+        // pattern and descriptors, so fills stay on the FIFO
+        if (Cache::available() && !Framebuffer::active() && w * h >= FILL_DMA_MIN_PIXELS) {
+            fillDma(x, y, x + w - 1, y + h - 1, color);
+            return;
+        }
+
+        setWindow(x, y, x + w - 1, y + h - 1);
+        writeColor(color, w * h);
+    }
+
+    // Function to define the vertical scrolling area
+    void setScrollArea(int top_fixed, int bottom_fixed) {
+        Dma::wait_all();
+        sendCommand(0x33);  // Vertical scrolling definition
+        sendData16(top_fixed);
+        sendData16(LCD_HEIGHT - top_fixed - bottom_fixed);
+        sendData16(bottom_fixed);
+    }
+
+    // Function to move the vertical scroll start address
+    void setScrollStart(int line) {
+        Dma::wait_all();
+        sendCommand(0x37);  // Vertical scrolling start address
+        sendData16(line);
+    }
+
+    // Function to draw a pixel on the LCD
+    void drawPixel(int x, int y, uint16_t color) {
+        fillRect(x, y, 1, 1, color);
+    }
+
+    // Function to clear the screen: one full-panel window, streamed by DMA
+    void clearScreen(uint16_t color) {
+        fillRect(0, 0, LCD_WIDTH, LCD_HEIGHT, color);
     }
 }
\ No newline at end of file
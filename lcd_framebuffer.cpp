@@ -0,0 +1,479 @@
+
+
+#include <cstdint>
+#include <cstring>
+#include "lcd.h"
+#include "lcd_internal.h"
+#include "memory_map.h"
+#include "mem_fill.h"
+#include "cache.h"
+#include "dma.h"
+#include "timer.h"
+
+// Off-screen RGB565 framebuffer with dirty-rectangle tracking.
+// Drawing goes to RAM at memory speed; flush() queues only what changed
+// on the DMA engine and returns while the pixels are on the wire.
+namespace LCDDriver {
+
+    // Inclusive rectangle in panel coordinates
+    struct DirtyRect {
+        int x0, y0, x1, y1;
+    };
+
+    // Number of separate dirty rectangles tracked before they get merged
+    constexpr int MAX_DIRTY_RECTS = 8;
+
+    static uint16_t* s_fb = nullptr;
+    static bool s_fb_active = false;
+
+    static DirtyRect s_dirty[MAX_DIRTY_RECTS];
+    static int s_dirty_count = 0;
+
+    // Descriptors are built per row, so a flush needs at most one per row
+    // of every dirty rectangle
+    constexpr int MAX_FLUSH_DESCRIPTORS = MAX_DIRTY_RECTS * LCD_HEIGHT;
+
+    // One queued DMA transfer per dirty rectangle
+    struct FlushJob {
+        DirtyRect rect;
+        uint32_t bytes;
+    };
+
+    static Dma::Descriptor* s_desc = nullptr;
+    static FlushJob s_jobs[MAX_DIRTY_RECTS];
+    static Dma::Handle s_flush_handle = 0;
+
+    // Double buffering: s_fb is always the buffer being drawn into and
+    // s_front the one last handed to the DMA engine
+    static uint16_t* s_front = nullptr;
+    static bool s_double = false;
+
+    // Sync source used by present()
+    static SyncSource s_sync = SyncSource::None;
+    static uint64_t s_frame_period = 0;  // cycles, Timer source only
+    static uint64_t s_last_sync = 0;
+
+    // Give up waiting for a TE edge after this long (panel not wired/enabled)
+    constexpr uint64_t TE_TIMEOUT_US = 50000;
+
+    // Transmission timestamps of the frame currently on the wire
+    static uint64_t s_xfer_start = 0;
+    static uint64_t s_xfer_end = 0;
+    static bool s_xfer_pending = false;
+
+    static PresentStats s_stats = {};
+    static uint64_t s_stats_start = 0;
+
+    // Current write window and stream cursor
+    static DirtyRect s_win = {0, 0, 0, 0};
+    static int s_cur_x = 0;
+    static int s_cur_y = 0;
+
+    static int rectArea(const DirtyRect& r) {
+        return (r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1);
+    }
+
+    static DirtyRect rectUnion(const DirtyRect& a, const DirtyRect& b) {
+        DirtyRect r;
+        r.x0 = a.x0 < b.x0 ? a.x0 : b.x0;
+        r.y0 = a.y0 < b.y0 ? a.y0 : b.y0;
+        r.x1 = a.x1 > b.x1 ? a.x1 : b.x1;
+        r.y1 = a.y1 > b.y1 ? a.y1 : b.y1;
+        return r;
+    }
+
+    // Touching or overlapping rectangles are merged so they go out in one window
+    static bool rectsTouch(const DirtyRect& a, const DirtyRect& b) {
+        return a.x0 <= b.x1 + 1 && b.x0 <= a.x1 + 1 &&
+               a.y0 <= b.y1 + 1 && b.y0 <= a.y1 + 1;
+    }
+
+    // Add a rectangle to the dirty list, merging where it does not cost extra
+    // bus time (overlap/adjacency) or when the list is full (least growth).
+    static void markDirty(DirtyRect r) {
+        if (r.x0 < 0) r.x0 = 0;
+        if (r.y0 < 0) r.y0 = 0;
+        if (r.x1 >= LCD_WIDTH) r.x1 = LCD_WIDTH - 1;
+        if (r.y1 >= LCD_HEIGHT) r.y1 = LCD_HEIGHT - 1;
+        if (r.x0 > r.x1 || r.y0 > r.y1) return;
+
+        // Absorb every existing rectangle that touches the new one
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (int i = 0; i < s_dirty_count; i++) {
+                if (rectsTouch(s_dirty[i], r)) {
+                    r = rectUnion(s_dirty[i], r);
+                    s_dirty[i] = s_dirty[--s_dirty_count];
+                    merged = true;
+                    break;
+                }
+            }
+        }
+
+        if (s_dirty_count < MAX_DIRTY_RECTS) {
+            s_dirty[s_dirty_count++] = r;
+            return;
+        }
+
+        // List full: grow whichever rectangle is enlarged the least
+        int best = 0;
+        int best_growth = 0;
+        for (int i = 0; i < s_dirty_count; i++) {
+            int growth = rectArea(rectUnion(s_dirty[i], r)) - rectArea(s_dirty[i]);
+            if (i == 0 || growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        s_dirty[best] = rectUnion(s_dirty[best], r);
+    }
+
+    bool Framebuffer::active() {
+        return s_fb_active;
+    }
+
+    void Framebuffer::setWindow(int x0, int y0, int x1, int y1) {
+        s_win.x0 = x0;
+        s_win.y0 = y0;
+        s_win.x1 = x1;
+        s_win.y1 = y1;
+        s_cur_x = x0;
+        s_cur_y = y0;
+        markDirty(s_win);
+    }
+
+    // Advance the stream cursor by n pixels within the current window row.
+    // Returns a pointer into the framebuffer for the visible part of the run
+    // and stores its length in `visible` (0 when the run is off-panel).
+    static uint16_t* advanceRun(int n, int& skip, int& visible) {
+        int x = s_cur_x;
+        int y = s_cur_y;
+        int end = x + n;  // exclusive
+
+        s_cur_x = end;
+        if (s_cur_x > s_win.x1) {
+            s_cur_x = s_win.x0;
+            s_cur_y = (s_cur_y >= s_win.y1) ? s_win.y0 : s_cur_y + 1;
+        }
+
+        skip = 0;
+        visible = 0;
+        if (y < 0 || y >= LCD_HEIGHT) return nullptr;
+        int vx0 = x < 0 ? 0 : x;
+        int vx1 = end > LCD_WIDTH ? LCD_WIDTH : end;
+        if (vx0 >= vx1) return nullptr;
+
+        skip = vx0 - x;
+        visible = vx1 - vx0;
+        return s_fb + y * LCD_WIDTH + vx0;
+    }
+
+    // Length of the run from the cursor to the end of the current window row
+    static int rowRemaining() {
+        return s_win.x1 - s_cur_x + 1;
+    }
+
+    void Framebuffer::writePixels(const uint16_t* pixels, int n) {
+        while (n > 0) {
+            int run = rowRemaining();
+            if (run <= 0) return;  // degenerate window
+            if (run > n) run = n;
+
+            int skip, visible;
+            uint16_t* dst = advanceRun(run, skip, visible);
+            for (int i = 0; i < visible; i++) {
+                dst[i] = toWire(pixels[skip + i]);
+            }
+            pixels += run;
+            n -= run;
+        }
+    }
+
+    void Framebuffer::writeColor(uint16_t color, int n) {
+        while (n > 0) {
+            int run = rowRemaining();
+            if (run <= 0) return;  // degenerate window
+            if (run > n) run = n;
+
+            int skip, visible;
+            uint16_t* dst = advanceRun(run, skip, visible);
+            uint16_t wire = toWire(color);
+            for (int i = 0; i < visible; i++) {
+                dst[i] = wire;
+            }
+            n -= run;
+        }
+    }
+
+    // Memory the DMA engine reads: `placement` if the cache can be written
+    // back before a transfer, otherwise uncached memory only
+    static void* allocDmaBuffer(std::size_t size, MemoryMap::Placement placement) {
+        if (!Cache::available()) placement = MemoryMap::Placement::Uncached;
+        return MemoryMap::alloc(size, 4, placement);
+    }
+
+    bool enableFramebuffer() {
+        if (s_fb_active) return true;
+
+        if (s_fb == nullptr) {
+            void* mem = allocDmaBuffer(LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t),
+                                       MemoryMap::Placement::Bulk);
+            if (mem == nullptr) return false;
+            s_fb = static_cast<uint16_t*>(mem);
+            MemFill::zero(s_fb, LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t));
+        }
+
+        if (s_desc == nullptr) {
+            void* mem = allocDmaBuffer(MAX_FLUSH_DESCRIPTORS * sizeof(Dma::Descriptor),
+                                       MemoryMap::Placement::Dma);
+            if (mem == nullptr) return false;
+            s_desc = static_cast<Dma::Descriptor*>(mem);
+        }
+
+        s_dirty_count = 0;
+        s_fb_active = true;
+        return true;
+    }
+
+    void disableFramebuffer() {
+        if (!s_fb_active) return;
+        flush();
+        flushWait();
+        s_fb_active = false;
+        s_double = false;
+    }
+
+    bool framebufferEnabled() {
+        return s_fb_active;
+    }
+
+    // DMA hooks for one dirty rectangle
+    static void flushJobStart(void* context) {
+        const FlushJob* job = static_cast<const FlushJob*>(context);
+        if (job == &s_jobs[0]) s_xfer_start = Timer::cycles();
+        Panel::beginDmaWindow(job->rect.x0, job->rect.y0, job->rect.x1, job->rect.y1, job->bytes);
+    }
+
+    static void flushJobComplete(void*) {
+        Panel::endDma();
+        s_xfer_end = Timer::cycles();
+    }
+
+    // Build the descriptor chain for one rectangle starting at s_desc[first].
+    // Full-width rectangles are contiguous in memory and are split into
+    // maximum-size descriptors; narrower ones get one descriptor per row.
+    // Returns the number of descriptors used.
+    static int buildChain(const uint16_t* fb, const DirtyRect& r, int first) {
+        int w = r.x1 - r.x0 + 1;
+        int h = r.y1 - r.y0 + 1;
+        Dma::Descriptor* d = s_desc + first;
+        int used = 0;
+
+        if (w == LCD_WIDTH) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(fb + r.y0 * LCD_WIDTH);
+            std::size_t remaining = static_cast<std::size_t>(w) * h * sizeof(uint16_t);
+            while (remaining > 0) {
+                std::size_t len = remaining < Dma::MAX_DESCRIPTOR_BYTES ? remaining : Dma::MAX_DESCRIPTOR_BYTES;
+                remaining -= len;
+                Dma::make_descriptor(d[used], p, len, &d[used + 1], remaining == 0);
+                p += len;
+                used++;
+            }
+        } else {
+            for (int row = 0; row < h; row++) {
+                const uint16_t* p = fb + (r.y0 + row) * LCD_WIDTH + r.x0;
+                Dma::make_descriptor(d[used], p, w * sizeof(uint16_t), &d[used + 1], row == h - 1);
+                used++;
+            }
+        }
+        Cache::writeback(d, used * sizeof(Dma::Descriptor));
+        return used;
+    }
+
+    // Write the CPU-drawn pixels of one rectangle back from the data cache
+    // so the DMA engine reads them, not stale memory
+    static void writebackRect(const uint16_t* fb, const DirtyRect& r) {
+        int w = r.x1 - r.x0 + 1;
+        if (w == LCD_WIDTH) {
+            Cache::writeback(fb + r.y0 * LCD_WIDTH, static_cast<std::size_t>(w) * (r.y1 - r.y0 + 1) * sizeof(uint16_t));
+            return;
+        }
+        for (int y = r.y0; y <= r.y1; y++) {
+            Cache::writeback(fb + y * LCD_WIDTH + r.x0, w * sizeof(uint16_t));
+        }
+    }
+
+    // Queue every dirty rectangle of `fb` on the DMA engine, one window each.
+    // The caller must have waited for the previous flush.
+    static void queueDirty(const uint16_t* fb) {
+        int next_desc = 0;
+        for (int i = 0; i < s_dirty_count; i++) {
+            FlushJob& job = s_jobs[i];
+            job.rect = s_dirty[i];
+            job.bytes = (job.rect.x1 - job.rect.x0 + 1) * (job.rect.y1 - job.rect.y0 + 1) * sizeof(uint16_t);
+
+            int first = next_desc;
+            writebackRect(fb, job.rect);
+            next_desc += buildChain(fb, job.rect, first);
+
+            Dma::Transfer t;
+            t.chain = &s_desc[first];
+            t.on_start = flushJobStart;
+            t.on_complete = flushJobComplete;
+            t.context = &job;
+            s_flush_handle = Dma::submit(t);
+        }
+        s_xfer_pending = s_dirty_count > 0;
+    }
+
+    // Function to queue each dirty rectangle on the DMA engine, one window each
+    void flush() {
+        if (!s_fb_active) return;
+        if (s_double) {
+            present();
+            return;
+        }
+
+        // Descriptors and job slots from the previous flush are reused
+        flushWait();
+        queueDirty(s_fb);
+        s_dirty_count = 0;
+    }
+
+    // Function to block until the last flush has reached the panel
+    void flushWait() {
+        Dma::wait(s_flush_handle);
+    }
+
+    void setSyncSource(SyncSource source, uint32_t refresh_hz) {
+        s_sync = source;
+        s_frame_period = refresh_hz ? Timer::CPU_HZ / refresh_hz : 0;
+        s_last_sync = Timer::cycles();
+        if (source == SyncSource::TearingPin) {
+            Panel::enableTearingOutput();
+        }
+    }
+
+    // Wait for the next rising edge of TE (start of vertical blanking)
+    static void waitTearingEdge() {
+        uint64_t deadline = Timer::cycles() + Timer::us_to_cycles(TE_TIMEOUT_US);
+        while (Panel::tearingLevel()) {
+            if (Timer::cycles() > deadline) return;
+        }
+        while (!Panel::tearingLevel()) {
+            if (Timer::cycles() > deadline) return;
+        }
+    }
+
+    // Wait for the next frame boundary of the timer stand-in
+    static void waitTimerTick() {
+        uint64_t deadline = s_last_sync + s_frame_period;
+        uint64_t now = Timer::cycles();
+        while (now < deadline) {
+            now = Timer::cycles();
+        }
+        // If we fell behind, realign to now rather than bursting to catch up
+        s_last_sync = (now - deadline < s_frame_period) ? deadline : now;
+    }
+
+    static void waitSync() {
+        switch (s_sync) {
+            case SyncSource::TearingPin:
+                waitTearingEdge();
+                break;
+            case SyncSource::Timer:
+                waitTimerTick();
+                break;
+            case SyncSource::None:
+                break;
+        }
+    }
+
+    bool enableDoubleBuffer() {
+        if (!s_fb_active) return false;
+        if (s_double) return true;
+
+        if (s_front == nullptr) {
+            void* mem = allocDmaBuffer(LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t),
+                                       MemoryMap::Placement::Bulk);
+            if (mem == nullptr) return false;
+            s_front = static_cast<uint16_t*>(mem);
+        }
+
+        // Both buffers start out identical; present() keeps them that way
+        flushWait();
+        memcpy(s_front, s_fb, LCD_WIDTH * LCD_HEIGHT * sizeof(uint16_t));
+        s_double = true;
+        return true;
+    }
+
+    // Copy one rectangle between the two buffers
+    static void copyRect(uint16_t* dst, const uint16_t* src, const DirtyRect& r) {
+        int w = r.x1 - r.x0 + 1;
+        for (int y = r.y0; y <= r.y1; y++) {
+            int offset = y * LCD_WIDTH + r.x0;
+            memcpy(dst + offset, src + offset, w * sizeof(uint16_t));
+        }
+    }
+
+    // Function to swap buffers and start sending the finished frame.
+    // The buffer that becomes the draw buffer was on the wire last frame, so
+    // present() first waits for it, then syncs it with the frame just finished
+    // while that frame is being transmitted.
+    void present() {
+        if (!s_fb_active) return;
+
+        uint64_t t0 = Timer::cycles();
+        if (s_stats.frames == 0) s_stats_start = t0;
+
+        if (!s_double) {
+            flush();
+            s_stats.frames++;
+            return;
+        }
+
+        flushWait();
+        uint64_t t1 = Timer::cycles();
+
+        if (s_xfer_pending) {
+            s_stats.transfer_cycles += s_xfer_end - s_xfer_start;
+            s_stats.blocked_cycles += t1 - t0;
+            s_xfer_pending = false;
+        }
+
+        uint16_t* finished = s_fb;
+        s_fb = s_front;
+        s_front = finished;
+
+        waitSync();
+        s_stats.sync_wait_cycles += Timer::cycles() - t1;
+
+        queueDirty(s_front);
+
+        // Bring the new draw buffer up to date with the finished frame
+        for (int i = 0; i < s_dirty_count; i++) {
+            copyRect(s_fb, s_front, s_dirty[i]);
+        }
+        s_dirty_count = 0;
+        s_stats.frames++;
+    }
+
+    PresentStats presentStats() {
+        PresentStats stats = s_stats;
+        uint64_t elapsed = Timer::cycles() - s_stats_start;
+        stats.fps = (stats.frames > 1 && elapsed > 0)
+                        ? static_cast<float>(stats.frames - 1) * Timer::CPU_HZ / elapsed
+                        : 0.0f;
+        stats.overlap_ratio = stats.transfer_cycles > 0
+                                  ? 1.0f - static_cast<float>(stats.blocked_cycles) / stats.transfer_cycles
+                                  : 0.0f;
+        if (stats.overlap_ratio < 0.0f) stats.overlap_ratio = 0.0f;
+        return stats;
+    }
+
+    void resetPresentStats() {
+        s_stats = PresentStats();
+        s_stats_start = Timer::cycles();
+    }
+}
@@ -0,0 +1,167 @@
+
+
+#include <cstdint>
+#include "lcd.h"
+#include "lcd_internal.h"
+#include "memory_map.h"
+
+// Cache of fully expanded 8x8 RGB565 glyph tiles keyed by (glyph, fg, bg).
+// Lookup goes through a small chained hash table; replacement is LRU via a
+// doubly linked list of entry indices. Tiles live in fast memory (Hot
+// placement) allocated on first use.
+namespace LCDDriver {
+
+    constexpr int GLYPH_CACHE_ENTRIES = 128;
+    constexpr int GLYPH_CACHE_BUCKETS = 64;   // power of two
+    constexpr int GLYPH_TILE_PIXELS = GLYPH_WIDTH * GLYPH_HEIGHT;
+    constexpr uint16_t NO_ENTRY = 0xFFFF;
+
+    struct GlyphEntry {
+        uint64_t key;
+        uint16_t hash_next;  // next entry in the same bucket
+        uint16_t lru_prev;   // towards most recently used
+        uint16_t lru_next;   // towards least recently used
+        bool valid;
+    };
+
+    static GlyphEntry s_entries[GLYPH_CACHE_ENTRIES];
+    static uint16_t s_buckets[GLYPH_CACHE_BUCKETS];
+    static uint16_t s_lru_head = NO_ENTRY;  // most recently used
+    static uint16_t s_lru_tail = NO_ENTRY;  // least recently used
+    static uint16_t* s_tiles = nullptr;
+    static bool s_cache_ready = false;
+
+    static GlyphCacheStats s_cache_stats = {};
+
+    // Scratch tile used when no memory could be carved for the cache
+    static uint16_t s_uncached_tile[GLYPH_TILE_PIXELS];
+
+    // Palette of the most recent miss, reused while colors stay the same
+    static Text::Palette s_palette;
+    static uint16_t s_palette_fg = 0;
+    static uint16_t s_palette_bg = 0;
+    static bool s_palette_valid = false;
+
+    static uint64_t makeKey(char c, uint16_t fg, uint16_t bg) {
+        return static_cast<uint64_t>(static_cast<unsigned char>(c)) |
+               (static_cast<uint64_t>(fg) << 8) |
+               (static_cast<uint64_t>(bg) << 24);
+    }
+
+    static int bucketOf(uint64_t key) {
+        uint32_t h = static_cast<uint32_t>(key ^ (key >> 17) ^ (key >> 31));
+        h *= 0x9E3779B1u;
+        return h >> (32 - 6);  // log2(GLYPH_CACHE_BUCKETS)
+    }
+
+    static_assert(GLYPH_CACHE_BUCKETS == 64, "bucketOf() assumes 64 buckets");
+
+    static void lruUnlink(uint16_t i) {
+        GlyphEntry& e = s_entries[i];
+        if (e.lru_prev != NO_ENTRY) s_entries[e.lru_prev].lru_next = e.lru_next;
+        else s_lru_head = e.lru_next;
+        if (e.lru_next != NO_ENTRY) s_entries[e.lru_next].lru_prev = e.lru_prev;
+        else s_lru_tail = e.lru_prev;
+    }
+
+    static void lruPushFront(uint16_t i) {
+        GlyphEntry& e = s_entries[i];
+        e.lru_prev = NO_ENTRY;
+        e.lru_next = s_lru_head;
+        if (s_lru_head != NO_ENTRY) s_entries[s_lru_head].lru_prev = i;
+        s_lru_head = i;
+        if (s_lru_tail == NO_ENTRY) s_lru_tail = i;
+    }
+
+    static void hashRemove(uint16_t i) {
+        int b = bucketOf(s_entries[i].key);
+        uint16_t* link = &s_buckets[b];
+        while (*link != NO_ENTRY) {
+            if (*link == i) {
+                *link = s_entries[i].hash_next;
+                return;
+            }
+            link = &s_entries[*link].hash_next;
+        }
+    }
+
+    // Carve tile storage and thread every entry onto the LRU list
+    static bool cacheInit() {
+        void* mem = MemoryMap::alloc(GLYPH_CACHE_ENTRIES * GLYPH_TILE_PIXELS * sizeof(uint16_t), 4,
+                                     MemoryMap::Placement::Hot);
+        if (mem == nullptr) return false;
+        s_tiles = static_cast<uint16_t*>(mem);
+
+        for (int b = 0; b < GLYPH_CACHE_BUCKETS; b++) {
+            s_buckets[b] = NO_ENTRY;
+        }
+        s_lru_head = NO_ENTRY;
+        s_lru_tail = NO_ENTRY;
+        for (int i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+            s_entries[i].valid = false;
+            s_entries[i].hash_next = NO_ENTRY;
+            lruPushFront(static_cast<uint16_t>(i));
+        }
+        s_cache_ready = true;
+        return true;
+    }
+
+    static const Text::Palette& paletteFor(uint16_t fg, uint16_t bg) {
+        if (!s_palette_valid || s_palette_fg != fg || s_palette_bg != bg) {
+            Text::makePalette(fg, bg, s_palette);
+            s_palette_fg = fg;
+            s_palette_bg = bg;
+            s_palette_valid = true;
+        }
+        return s_palette;
+    }
+
+    const uint16_t* Text::glyphTile(char c, uint16_t fg, uint16_t bg) {
+        if (!s_cache_ready && !cacheInit()) {
+            s_cache_stats.misses++;
+            expandGlyph(c, paletteFor(fg, bg), s_uncached_tile, GLYPH_WIDTH);
+            return s_uncached_tile;
+        }
+
+        uint64_t key = makeKey(c, fg, bg);
+        int b = bucketOf(key);
+        for (uint16_t i = s_buckets[b]; i != NO_ENTRY; i = s_entries[i].hash_next) {
+            if (s_entries[i].key == key) {
+                s_cache_stats.hits++;
+                if (s_lru_head != i) {
+                    lruUnlink(i);
+                    lruPushFront(i);
+                }
+                return s_tiles + i * GLYPH_TILE_PIXELS;
+            }
+        }
+
+        // Miss: recycle the least recently used entry
+        s_cache_stats.misses++;
+        uint16_t victim = s_lru_tail;
+        GlyphEntry& e = s_entries[victim];
+        if (e.valid) {
+            hashRemove(victim);
+            s_cache_stats.evictions++;
+        }
+
+        e.key = key;
+        e.valid = true;
+        e.hash_next = s_buckets[b];
+        s_buckets[b] = victim;
+        lruUnlink(victim);
+        lruPushFront(victim);
+
+        uint16_t* tile = s_tiles + victim * GLYPH_TILE_PIXELS;
+        expandGlyph(c, paletteFor(fg, bg), tile, GLYPH_WIDTH);
+        return tile;
+    }
+
+    GlyphCacheStats glyphCacheStats() {
+        return s_cache_stats;
+    }
+
+    void resetGlyphCacheStats() {
+        s_cache_stats = GlyphCacheStats();
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef LCD_INTERNAL_H
+#define LCD_INTERNAL_H
+
+#include <cstdint>
+
+// Private interfaces shared between the LCD driver translation units.
+// Not part of the public LCDDriver API in lcd.h.
+namespace LCDDriver {
+    // RGB565 in wire byte order (high byte first) as stored in memory, so
+    // the DMA engine can stream pixel buffers without conversion
+    inline uint16_t toWire(uint16_t color) {
+        return static_cast<uint16_t>((color >> 8) | (color << 8));
+    }
+
+    // Primitives that always go straight to the panel over SPI,
+    // bypassing the off-screen framebuffer
+    namespace Panel {
+        void setWindow(int x0, int y0, int x1, int y1);
+        void writePixels(const uint16_t* pixels, int n);
+        void writeColor(uint16_t color, int n);
+
+        // DMA data phase: program the window, then let the DMA engine
+        // stream `bytes` of pixel data. Used from Dma transfer hooks, so
+        // it does not wait for the queue.
+        void beginDmaWindow(int x0, int y0, int x1, int y1, uint32_t bytes);
+        void endDma();
+
+        // Turn on the panel's TE output (V-blank only)
+        void enableTearingOutput();
+
+        // Current level of the TE input pin
+        bool tearingLevel();
+    }
+
+    // Off-screen framebuffer backend used while enableFramebuffer() is active
+    namespace Framebuffer {
+        bool active();
+        void setWindow(int x0, int y0, int x1, int y1);
+        void writePixels(const uint16_t* pixels, int n);
+        void writeColor(uint16_t color, int n);
+    }
+
+    // Glyph expansion shared by the text renderers
+    namespace Text {
+        // Four-pixel RGB565 expansion of every nibble for one fg/bg pair
+        struct Palette {
+            uint16_t px[16][4];
+        };
+
+        void makePalette(uint16_t fg, uint16_t bg, Palette& palette);
+
+        // Expand the 8x8 glyph for `c` into dst (row stride in pixels)
+        void expandGlyph(char c, const Palette& palette, uint16_t* dst, int stride);
+
+        // Expanded 8x8 tile (row stride GLYPH_WIDTH) from the glyph cache.
+        // Valid until the next call.
+        const uint16_t* glyphTile(char c, uint16_t fg, uint16_t bg);
+    }
+}
+
+#endif // LCD_INTERNAL_H
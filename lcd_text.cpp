@@ -0,0 +1,115 @@
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "lcd.h"
+#include "lcd_internal.h"
+#include "font8x8.h"
+
+// Text rendering from font8x8_basic.
+// Each glyph row byte is split into two nibbles and every nibble is expanded
+// to four RGB565 pixels through a lookup table, so a glyph row costs two
+// 8-byte copies instead of eight bit tests. Print goes through the glyph
+// cache (lcd_glyph_cache.cpp), so repeated text is a plain tile copy.
+namespace LCDDriver {
+
+    // First character covered by font8x8_basic
+    constexpr int FONT_FIRST_CHAR = 0x20;
+    constexpr int FONT_NUM_CHARS = 96;
+
+    // Nibble-to-pixel mask table: entry [n][i] is 0xFFFF when pixel i of
+    // nibble n is set. Bit 3 of a nibble is its leftmost pixel, matching the
+    // MSB-first row layout of font8x8_basic.
+    struct NibbleMasks {
+        uint16_t mask[16][4];
+    };
+
+    static constexpr NibbleMasks makeNibbleMasks() {
+        NibbleMasks t = {};
+        for (int n = 0; n < 16; n++) {
+            for (int i = 0; i < 4; i++) {
+                t.mask[n][i] = (n & (8 >> i)) ? 0xFFFF : 0x0000;
+            }
+        }
+        return t;
+    }
+
+    static constexpr NibbleMasks NIBBLE_MASKS = makeNibbleMasks();
+
+    // Line buffer for one row of glyphs (GLYPH_HEIGHT rows, up to the panel width)
+    static uint16_t s_line[GLYPH_HEIGHT * LCD_WIDTH];
+
+    void Text::makePalette(uint16_t fg, uint16_t bg, Palette& palette) {
+        for (int n = 0; n < 16; n++) {
+            for (int i = 0; i < 4; i++) {
+                uint16_t m = NIBBLE_MASKS.mask[n][i];
+                palette.px[n][i] = (fg & m) | (bg & ~m);
+            }
+        }
+    }
+
+    // Font rows for a character; characters outside the table render blank
+    static const uint8_t* glyphRows(char c) {
+        int index = static_cast<unsigned char>(c) - FONT_FIRST_CHAR;
+        if (index < 0 || index >= FONT_NUM_CHARS) index = 0;
+        return font8x8_basic[index];
+    }
+
+    void Text::expandGlyph(char c, const Palette& palette, uint16_t* dst, int stride) {
+        const uint8_t* rows = glyphRows(c);
+        for (int row = 0; row < GLYPH_HEIGHT; row++) {
+            uint8_t bits = rows[row];
+            memcpy(dst, palette.px[bits >> 4], sizeof(palette.px[0]));
+            memcpy(dst + 4, palette.px[bits & 0x0F], sizeof(palette.px[0]));
+            dst += stride;
+        }
+    }
+
+    // Copy an 8x8 tile into the line buffer
+    static void copyTile(const uint16_t* tile, uint16_t* dst, int stride) {
+        for (int row = 0; row < GLYPH_HEIGHT; row++) {
+            memcpy(dst, tile, GLYPH_WIDTH * sizeof(uint16_t));
+            tile += GLYPH_WIDTH;
+            dst += stride;
+        }
+    }
+
+    // Function to print a string: render the visible part of the line into
+    // the line buffer and send it through a single address window
+    void Print(const char* str, int x, int y, uint16_t color, uint16_t bg) {
+        // Characters that intersect the panel horizontally
+        int len = static_cast<int>(strlen(str));
+        int first = x < 0 ? (-x + GLYPH_WIDTH - 1) / GLYPH_WIDTH : 0;
+        int last = len;
+        if (x + last * GLYPH_WIDTH > LCD_WIDTH) {
+            last = (LCD_WIDTH - x) / GLYPH_WIDTH;
+        }
+        if (first >= last) return;
+
+        // Rows that intersect the panel vertically
+        int row0 = y < 0 ? -y : 0;
+        int row1 = (y + GLYPH_HEIGHT > LCD_HEIGHT) ? LCD_HEIGHT - y : GLYPH_HEIGHT;
+        if (row0 >= row1) return;
+
+        int count = last - first;
+        int stride = count * GLYPH_WIDTH;
+        for (int i = 0; i < count; i++) {
+            copyTile(Text::glyphTile(str[first + i], color, bg), s_line + i * GLYPH_WIDTH, stride);
+        }
+
+        int x0 = x + first * GLYPH_WIDTH;
+        setWindow(x0, y + row0, x0 + stride - 1, y + row1 - 1);
+        writePixels(s_line + row0 * stride, (row1 - row0) * stride);
+    }
+
+    void Print(const char* str, int x, int y, uint16_t color) {
+        Print(str, x, y, color, 0x0000);
+    }
+
+    void Print(int number, int x, int y, uint16_t color) {
+        char buffer[12];  // Buffer to hold the integer as a string
+        snprintf(buffer, sizeof(buffer), "%d", number);  // Convert integer to string
+        Print(buffer, x, y, color);  // Reuse the string Print function
+    }
+}
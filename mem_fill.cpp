@@ -0,0 +1,249 @@
+/*
+ * micro32/mem_fill.cpp
+ *
+ * Fill / zero engine. See mem_fill.h for the strategies.
+ *
+ * Notes:
+ *  - All paths share the unrolled word loop for the unaligned head and the
+ *    tail, so the faster paths only ever see aligned, whole blocks.
+ *  - The mem-to-mem DMA register map is a placeholder modelled on an ESP32
+ *    GDMA channel pair; replace the addresses with the actual ones.
+ *  - DMA does not snoop the data cache. The pattern block and descriptors
+ *    are written back before the channel reads them; the destination is
+ *    written back and invalidated before the transfer (so no dirty line
+ *    lands on the result) and invalidated again after it (so no line
+ *    fetched meanwhile is read stale).
+ */
+
+#include "mem_fill.h"
+#include "cache.h"
+#include "dma.h"
+#include "mmio.h"
+#include "timer.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// Define memory-mapped registers for the mem-to-mem DMA channel
+#define M2M_BASE 0x60080100                      // Replace with the actual channel base address
+#define M2M_OUT_LINK_ADDR_REG (M2M_BASE + 0x00)  // first source descriptor
+#define M2M_IN_LINK_ADDR_REG (M2M_BASE + 0x04)   // first destination descriptor
+#define M2M_LINK_CTRL_REG (M2M_BASE + 0x08)      // bit 0: start out link, bit 1: start in link
+#define M2M_INT_RAW_REG (M2M_BASE + 0x0C)        // bit 0: in_suc_eof (chain written)
+#define M2M_INT_CLR_REG (M2M_BASE + 0x10)        // write 1 to clear
+#define M2M_CONF_REG (M2M_BASE + 0x14)           // bit 0: reset, bit 4: mem_trans_en
+
+namespace MemFill {
+
+// Descriptors per DMA batch (about 64 KiB per batch)
+constexpr int DMA_BATCH = 16;
+constexpr std::size_t DMA_CHUNK = Dma::MAX_DESCRIPTOR_BYTES;
+
+// Source block the channel copies from, holding the current pattern
+alignas(64) static uint32_t s_pattern_block[DMA_CHUNK / 4];
+static uint32_t s_block_pattern = 0;  // BSS starts zeroed
+static Dma::Descriptor s_out_desc[DMA_BATCH];
+static Dma::Descriptor s_in_desc[DMA_BATCH];
+
+static inline uint32_t rotr8(uint32_t v) {
+    return (v >> 8) | (v << 24);
+}
+
+// Unrolled word stores; handles any alignment and length. Returns the
+// pattern rotated to the phase of the byte after the range.
+static uint32_t fill_words(uint8_t* p, uint32_t pattern, std::size_t n) {
+    // Byte stores up to word alignment
+    while ((reinterpret_cast<uintptr_t>(p) & 3) != 0 && n > 0) {
+        *p++ = static_cast<uint8_t>(pattern);
+        pattern = rotr8(pattern);
+        n--;
+    }
+
+    uint32_t* w = reinterpret_cast<uint32_t*>(p);
+    while (n >= 32) {
+        w[0] = pattern;
+        w[1] = pattern;
+        w[2] = pattern;
+        w[3] = pattern;
+        w[4] = pattern;
+        w[5] = pattern;
+        w[6] = pattern;
+        w[7] = pattern;
+        w += 8;
+        n -= 32;
+    }
+    while (n >= 4) {
+        *w++ = pattern;
+        n -= 4;
+    }
+
+    p = reinterpret_cast<uint8_t*>(w);
+    while (n > 0) {
+        *p++ = static_cast<uint8_t>(pattern);
+        pattern = rotr8(pattern);
+        n--;
+    }
+    return pattern;
+}
+
+#if defined(__riscv_zicboz)
+// Zero whole cache blocks; `p` and `n` are CBO_BLOCK aligned
+static void zero_blocks(uint8_t* p, std::size_t n) {
+    for (uint8_t* end = p + n; p < end; p += CBO_BLOCK) {
+        asm volatile("cbo.zero (%0)" : : "r"(p) : "memory");
+    }
+}
+#endif
+
+#ifndef MICRO32_HOST
+
+// --- Hardware backend ---
+
+static void m2m_run(Dma::Descriptor* out, Dma::Descriptor* in) {
+    Mmio::write32(M2M_CONF_REG, (1 << 0) | (1 << 4));  // Reset, memory mode
+    Mmio::write32(M2M_CONF_REG, 1 << 4);
+    Mmio::write32(M2M_INT_CLR_REG, 1);
+
+    __sync_synchronize();
+    Mmio::write32(M2M_OUT_LINK_ADDR_REG, reinterpret_cast<uintptr_t>(out));
+    Mmio::write32(M2M_IN_LINK_ADDR_REG, reinterpret_cast<uintptr_t>(in));
+    Mmio::write32(M2M_LINK_CTRL_REG, (1 << 0) | (1 << 1));
+
+    while ((Mmio::read32(M2M_INT_RAW_REG) & (1 << 0)) == 0) {
+        // Wait for the last destination descriptor
+    }
+    Mmio::write32(M2M_INT_CLR_REG, 1);
+}
+
+#else
+
+// --- Host model: copy each source descriptor into its destination ---
+
+static void m2m_run(Dma::Descriptor* out, Dma::Descriptor* in) {
+    for (; out != nullptr && in != nullptr; out = out->next, in = in->next) {
+        std::size_t length = in->config & 0xFFFu;
+        memcpy(const_cast<void*>(in->buffer), out->buffer, length);
+    }
+}
+
+#endif
+
+// Fill a word-aligned range whose pattern phase starts at byte 0
+static void fill_dma(uint8_t* p, uint32_t pattern, std::size_t n) {
+    if (pattern != s_block_pattern) {
+        fill_words(reinterpret_cast<uint8_t*>(s_pattern_block), pattern, sizeof(s_pattern_block));
+        s_block_pattern = pattern;
+        Cache::writeback(s_pattern_block, sizeof(s_pattern_block));
+    }
+    Cache::writeback_invalidate(p, n - n % DMA_CHUNK);
+
+    while (n >= DMA_CHUNK) {
+        int count = 0;
+        while (count < DMA_BATCH && n >= DMA_CHUNK) {
+            bool last = count == DMA_BATCH - 1 || n < 2 * DMA_CHUNK;
+            Dma::make_descriptor(s_out_desc[count], s_pattern_block, DMA_CHUNK,
+                                 &s_out_desc[count + 1], last);
+            Dma::make_descriptor(s_in_desc[count], p, DMA_CHUNK,
+                                 &s_in_desc[count + 1], last);
+            p += DMA_CHUNK;
+            n -= DMA_CHUNK;
+            count++;
+        }
+        Cache::writeback(s_out_desc, sizeof(s_out_desc));
+        Cache::writeback(s_in_desc, sizeof(s_in_desc));
+        m2m_run(s_out_desc, s_in_desc);
+        Cache::invalidate(p - count * DMA_CHUNK, count * DMA_CHUNK);
+    }
+
+    // DMA_CHUNK is a whole number of words, so the phase is unchanged
+    fill_words(p, pattern, n);
+}
+
+bool available(Strategy strategy) {
+    switch (strategy) {
+    case Strategy::CacheBlock:
+#if defined(__riscv_zicboz)
+        return true;
+#else
+        return false;
+#endif
+    case Strategy::Dma:
+        return Cache::available();
+    default:
+        return true;
+    }
+}
+
+static Strategy choose(std::size_t bytes, bool zero) {
+    if (bytes >= DMA_MIN_BYTES && available(Strategy::Dma)) return Strategy::Dma;
+    if (zero && bytes >= CACHE_BLOCK_MIN_BYTES && available(Strategy::CacheBlock)) {
+        return Strategy::CacheBlock;
+    }
+    return Strategy::Words;
+}
+
+void fill32(void* dst, uint32_t pattern, std::size_t bytes, Strategy strategy) {
+    uint8_t* p = static_cast<uint8_t*>(dst);
+    if (strategy == Strategy::Auto) strategy = choose(bytes, pattern == 0);
+    if (strategy == Strategy::CacheBlock && pattern != 0) strategy = Strategy::Words;
+    if (!available(strategy)) strategy = Strategy::Words;
+
+    switch (strategy) {
+    case Strategy::Dma: {
+        // Word-align with the CPU, keeping the pattern phase
+        std::size_t head = (4 - (reinterpret_cast<uintptr_t>(p) & 3)) & 3;
+        if (head > bytes) head = bytes;
+        pattern = fill_words(p, pattern, head);
+        fill_dma(p + head, pattern, bytes - head);
+        break;
+    }
+#if defined(__riscv_zicboz)
+    case Strategy::CacheBlock: {
+        uintptr_t start = reinterpret_cast<uintptr_t>(p);
+        uintptr_t end = start + bytes;
+        uintptr_t block_start = (start + CBO_BLOCK - 1) & ~(uintptr_t)(CBO_BLOCK - 1);
+        uintptr_t block_end = end & ~(uintptr_t)(CBO_BLOCK - 1);
+        if (block_start >= block_end) {
+            fill_words(p, 0, bytes);
+            break;
+        }
+        fill_words(p, 0, block_start - start);
+        zero_blocks(reinterpret_cast<uint8_t*>(block_start), block_end - block_start);
+        fill_words(reinterpret_cast<uint8_t*>(block_end), 0, end - block_end);
+        break;
+    }
+#endif
+    default:
+        fill_words(p, pattern, bytes);
+        break;
+    }
+}
+
+void zero(void* dst, std::size_t bytes, Strategy strategy) {
+    fill32(dst, 0, bytes, strategy);
+}
+
+int benchmark(void* buffer, std::size_t bytes, BenchResult* out, int max) {
+    const Strategy strategies[] = {Strategy::Words, Strategy::CacheBlock, Strategy::Dma};
+    int count = 0;
+
+    for (Strategy s : strategies) {
+        if (count >= max) break;
+        if (!available(s)) continue;
+
+        zero(buffer, bytes, s);  // Warm up (TLB, cache state)
+        uint64_t start = Timer::cycles();
+        zero(buffer, bytes, s);
+        uint64_t elapsed = Timer::cycles() - start;
+        if (elapsed == 0) elapsed = 1;
+
+        out[count].strategy = s;
+        out[count].cycles = elapsed;
+        out[count].mb_per_s = static_cast<uint32_t>(
+            static_cast<uint64_t>(bytes) * Timer::CPU_HZ / elapsed / 1000000u);
+        count++;
+    }
+    return count;
+}
+
+} // namespace MemFill
@@ -0,0 +1,71 @@
+#ifndef MICRO32_MEM_FILL_H
+#define MICRO32_MEM_FILL_H
+
+// mem_fill.h
+// Shared memory fill / zero engine for the kernel (page zeroing, carve(),
+// calloc, boot-time clears).
+//
+// Strategies, picked by size in Strategy::Auto:
+//  - Words:      unrolled stores, eight 32-bit words per iteration. Used for
+//                small ranges and for the unaligned head/tail of the others.
+//  - CacheBlock: Zicboz `cbo.zero`, one whole cache block per instruction
+//                without reading the line from memory first. Zero only; only
+//                compiled in when the toolchain targets Zicboz.
+//  - Dma:        a GDMA memory-to-memory channel copies a static pattern block
+//                over the range. Worth it for large PSRAM ranges where the
+//                CPU would stall on write-allocate misses; the CPU spins
+//                until the channel finishes. Needs cache maintenance to stay
+//                coherent (cache.h), so it is only available, and only
+//                picked by Auto, when Cache::available().
+//
+// benchmark() measures each available strategy on a caller-supplied buffer
+// and reports throughput, so the thresholds can be tuned per board.
+//
+// Thread-safety: the DMA channel is shared; callers must serialise large
+// fills (the kernel does all of them before concurrency is enabled).
+
+#include <cstdint>
+#include <cstddef>
+#include "cache.h"
+
+namespace MemFill {
+
+enum class Strategy : uint8_t {
+    Auto,
+    Words,
+    CacheBlock,
+    Dma,
+};
+
+// Ranges at or above these sizes use the faster path when available
+constexpr std::size_t CACHE_BLOCK_MIN_BYTES = 256;
+constexpr std::size_t DMA_MIN_BYTES = 64u * 1024u;
+
+// Zicboz cache block size
+constexpr std::size_t CBO_BLOCK = Cache::LINE_SIZE;
+
+// Zero `bytes` bytes at `dst`
+void zero(void* dst, std::size_t bytes, Strategy strategy = Strategy::Auto);
+
+// Fill `bytes` bytes at `dst` with the 32-bit `pattern`, repeated in memory
+// order from `dst` (so a word-aligned dst sees whole pattern words). The
+// CacheBlock strategy only applies to a zero pattern. Unavailable
+// strategies fall back to Words.
+void fill32(void* dst, uint32_t pattern, std::size_t bytes, Strategy strategy = Strategy::Auto);
+
+// True if `strategy` is usable in this build
+bool available(Strategy strategy);
+
+struct BenchResult {
+    Strategy strategy;
+    uint64_t cycles;       // cycles to zero the buffer once
+    uint32_t mb_per_s;     // throughput in MB/s (10^6 bytes per second)
+};
+
+// Zero `buffer` once with each available strategy. Fills up to `max`
+// entries of `out` and returns how many strategies were measured.
+int benchmark(void* buffer, std::size_t bytes, BenchResult* out, int max);
+
+} // namespace MemFill
+
+#endif // MICRO32_MEM_FILL_H
@@ -0,0 +1,161 @@
+/*
+ * micro32/mem_stats.cpp
+ *
+ * Allocation counters and histograms. See mem_stats.h.
+ *
+ * Notes:
+ *  - Free-space figures are not tracked incrementally; snapshot() asks the
+ *    allocators, so the hooks stay cheap.
+ *  - dump() formats lines with TextFormat to avoid pulling printf into the
+ *    kernel.
+ */
+
+#include "mem_stats.h"
+#include "heap.h"
+#include "page_allocator.h"
+#include "text_format.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace MemStats {
+
+static Stats s_stats[SOURCE_COUNT];
+
+static const char* const SOURCE_NAMES[SOURCE_COUNT] = {"heap", "pages"};
+
+// floor(log2(v)) clamped to the histogram, 0 for v <= 1
+static inline int bucket_of(uint64_t v) {
+    if (v <= 1) return 0;
+    int b = 63 - __builtin_clzll(v);
+    return b < HISTOGRAM_BUCKETS ? b : HISTOGRAM_BUCKETS - 1;
+}
+
+void record_alloc(Source source, std::size_t requested, std::size_t charged, uint64_t cycles) {
+    Stats& st = s_stats[source];
+    st.allocs++;
+    st.bytes_in_use += charged;
+    if (st.bytes_in_use > st.peak_bytes) st.peak_bytes = st.bytes_in_use;
+    if (cycles > st.max_cycles) st.max_cycles = cycles;
+    st.size_histogram[bucket_of(requested)]++;
+    st.latency_histogram[bucket_of(cycles)]++;
+}
+
+void record_failure(Source source, std::size_t requested) {
+    Stats& st = s_stats[source];
+    st.failures++;
+    st.size_histogram[bucket_of(requested)]++;
+}
+
+void record_free(Source source, std::size_t charged) {
+    Stats& st = s_stats[source];
+    st.frees++;
+    st.bytes_in_use -= charged;
+}
+
+Stats snapshot(Source source) {
+    Stats st = s_stats[source];
+
+    if (source == SOURCE_HEAP) {
+        Heap::Stats heap = Heap::stats();
+        st.free_bytes = heap.free_bytes;
+        st.largest_free = heap.largest_free;
+    } else {
+        PageAllocator::Stats pages = PageAllocator::stats();
+        st.free_bytes = pages.free_pages * PageAllocator::PAGE_SIZE;
+        st.largest_free = pages.free_pages ? PageAllocator::PAGE_SIZE << pages.largest_free_order : 0;
+    }
+
+    st.fragmentation = 0;
+    if (st.free_bytes > 0 && st.largest_free < st.free_bytes) {
+        st.fragmentation = static_cast<uint32_t>(
+            1000 - static_cast<uint64_t>(st.largest_free) * 1000 / st.free_bytes);
+    }
+    return st;
+}
+
+void reset() {
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        Stats& st = s_stats[s];
+        std::size_t in_use = st.bytes_in_use;
+        st = Stats{};
+        st.bytes_in_use = in_use;
+        st.peak_bytes = in_use;
+    }
+}
+
+// --- Text output ---
+
+using TextFormat::Line;
+
+static void start_line(Line& line, int source) {
+    line.clear();
+    line.add(SOURCE_NAMES[source]);
+    line.add(": ");
+}
+
+// Non-empty buckets as "2^k:count", a few per line
+static void dump_histogram(LineSink sink, int source, const char* label, const uint32_t* histogram) {
+    constexpr int PER_LINE = 3;
+    Line line;
+    int on_line = 0;
+    for (int k = 0; k < HISTOGRAM_BUCKETS; k++) {
+        if (histogram[k] == 0) continue;
+        if (on_line == 0) {
+            start_line(line, source);
+            line.add(label);
+        }
+        line.add(" 2^");
+        line.add(static_cast<uint64_t>(k));
+        line.add(":");
+        line.add(static_cast<uint64_t>(histogram[k]));
+        if (++on_line == PER_LINE) {
+            sink(line.text);
+            on_line = 0;
+        }
+    }
+    if (on_line != 0) sink(line.text);
+}
+
+void dump(LineSink sink) {
+    for (int s = 0; s < SOURCE_COUNT; s++) {
+        Stats st = snapshot(static_cast<Source>(s));
+        Line line;
+
+        start_line(line, s);
+        line.add("use ");
+        line.add(static_cast<uint64_t>(st.bytes_in_use));
+        line.add(" peak ");
+        line.add(static_cast<uint64_t>(st.peak_bytes));
+        sink(line.text);
+
+        start_line(line, s);
+        line.add("alloc ");
+        line.add(st.allocs);
+        line.add(" free ");
+        line.add(st.frees);
+        line.add(" fail ");
+        line.add(st.failures);
+        sink(line.text);
+
+        start_line(line, s);
+        line.add("free ");
+        line.add(static_cast<uint64_t>(st.free_bytes));
+        line.add(" max ");
+        line.add(static_cast<uint64_t>(st.largest_free));
+        sink(line.text);
+
+        start_line(line, s);
+        line.add("frag ");
+        line.add(static_cast<uint64_t>(st.fragmentation / 10));
+        line.add(".");
+        line.add(static_cast<uint64_t>(st.fragmentation % 10));
+        line.add("% maxlat ");
+        line.add(st.max_cycles);
+        sink(line.text);
+
+        dump_histogram(sink, s, "size", st.size_histogram);
+        dump_histogram(sink, s, "lat", st.latency_histogram);
+    }
+}
+
+} // namespace MemStats
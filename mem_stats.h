@@ -0,0 +1,87 @@
+#ifndef MICRO32_MEM_STATS_H
+#define MICRO32_MEM_STATS_H
+
+// mem_stats.h
+// Allocation instrumentation for the memory subsystem.
+//
+// The heap and the page allocator report every allocation and free here:
+// bytes in use and peak, a size histogram, a latency histogram (cycles read
+// with rdcycle via Timer::cycles()) and failure counts. Recording is a few
+// integer increments and one count-leading-zeros per call, so it is meant
+// to stay enabled in production builds; define MICRO32_MEM_STATS=0 to
+// compile the hooks out.
+//
+// snapshot() also computes an external fragmentation score for the source:
+// 1000 * (1 - largest free block / total free bytes), i.e. 0 when all free
+// memory is one block and close to 1000 when it is scattered in fragments.
+//
+// dump() formats everything as short text lines and hands them to a line
+// sink, e.g. a serial log or the LCD console.
+//
+// Thread-safety: none; callers must serialise access (the allocators
+// already require it).
+
+#include <cstdint>
+#include <cstddef>
+#include "timer.h"
+
+#ifndef MICRO32_MEM_STATS
+#define MICRO32_MEM_STATS 1
+#endif
+
+namespace MemStats {
+
+enum Source {
+    SOURCE_HEAP,
+    SOURCE_PAGES,
+    SOURCE_COUNT,
+};
+
+// Histogram bucket k counts values in [2^k, 2^(k+1)); the last bucket also
+// takes everything larger
+constexpr int HISTOGRAM_BUCKETS = 24;
+
+struct Stats {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t failures;
+    std::size_t bytes_in_use;      // bytes charged to live allocations
+    std::size_t peak_bytes;
+    uint64_t max_cycles;           // slowest allocation
+    uint32_t size_histogram[HISTOGRAM_BUCKETS];     // requested bytes
+    uint32_t latency_histogram[HISTOGRAM_BUCKETS];  // cycles per allocation
+    std::size_t free_bytes;        // filled in by snapshot()
+    std::size_t largest_free;      // filled in by snapshot()
+    uint32_t fragmentation;        // 0..1000, filled in by snapshot()
+};
+
+// Start timestamp for the latency hooks (0 when compiled out)
+inline uint64_t now() {
+#if MICRO32_MEM_STATS
+    return Timer::cycles();
+#else
+    return 0;
+#endif
+}
+
+// Hooks called by the allocators. `charged` is what the allocation costs
+// the pool (block or page size); `cycles` the time the call took.
+void record_alloc(Source source, std::size_t requested, std::size_t charged, uint64_t cycles);
+void record_failure(Source source, std::size_t requested);
+void record_free(Source source, std::size_t charged);
+
+// Counters plus current free-space figures of `source`
+Stats snapshot(Source source);
+
+// Forget counters and histograms (bytes in use are kept)
+void reset();
+
+// Receives one formatted line at a time (no trailing newline)
+using LineSink = void (*)(const char* line);
+
+// Write a readable summary of every source to `sink`
+void dump(LineSink sink);
+
+} // namespace MemStats
+
+#endif // MICRO32_MEM_STATS_H
@@ -7,14 +7,19 @@
  *  - Prefer a linker-provided symbol `__ram_end` (weak). If present and non-null,
  *    this is used together with the DEFAULT_RAM_BASE to derive the RAM end.
  *    This avoids probing memory at runtime.
- *  - If the symbol is not present, uses the compile-time defaults:
- *      DEFAULT_RAM_BASE (0x3F800000) and DEFAULT_RAM_SIZE (32 MiB)
- *    or the values previously configured through set_ram_bounds().
+ *  - If the symbol is not present, uses the values previously configured
+ *    through set_ram_bounds(), or probes the PSRAM size at DEFAULT_RAM_BASE.
+ *    Host builds fall back to DEFAULT_RAM_SIZE (32 MiB) instead of probing.
  *
  * Reservation semantics:
  *  - reserve_all_except_first_8kb() computes a usable region starting at
  *    (ram_base + RESERVED_PREFIX) up to ram_base + ram_size, records it
- *    internally and optionally zeroes it.
+ *    internally. Zeroing is lazy: when requested, the whole region is only
+ *    marked as needing zero, and carve() / the page allocator clear memory
+ *    on first hand-out. This keeps a 32 MiB sweep off the boot path.
+ *  - carve() hands out permanent blocks from the top of that region, so
+ *    get_usable_region() shrinks accordingly, until an allocator takes the
+ *    region over and installs a carve backend.
  *
  * Notes:
  *  - The symbol `__ram_end` is declared weakly. If you provide a linker
@@ -24,9 +29,17 @@
  */
 
 #include "memory_manager.h"
+#include "mem_fill.h"
+#include "cache.h"
+#include "timer.h"
 #include <cstdint>
 #include <cstddef>
 
+// Offset from the cached PSRAM window to its non-cacheable alias, so probe
+// writes reach the chip instead of sitting in the data cache. 0 means there
+// is no alias and the probe maintains the cache line by line instead.
+#define PSRAM_UNCACHED_OFFSET 0x00000000 // Replace with the actual uncached alias offset
+
 namespace MemoryManager {
 
 // Weak reference to a linker-provided symbol marking the end of RAM.
@@ -39,8 +52,15 @@ extern "C" {
 static uintptr_t s_ram_base = DEFAULT_RAM_BASE;
 static std::size_t s_ram_size = DEFAULT_RAM_SIZE;
 static Region s_reserved_region = {0, 0};
+static uintptr_t s_carve_top = 0; // usable region is [start, s_carve_top)
+static CarveBackend s_carve_backend = nullptr;
 static bool s_reserved = false;
+static bool s_zero_pending = false; // usable region still owes zeroing
 static bool s_explicit_bounds_set = false;
+static ProbeResult s_probe = {0, 0, false};
+
+// Marker written at the probe addresses; the low bits vary per step
+constexpr uint32_t PROBE_MARKER = 0x5AC3E100u;
 
 // Helper: compute ram_end using linker symbol if available and meaningful.
 static uintptr_t compute_ram_end_from_linker() {
@@ -56,6 +76,61 @@ static uintptr_t compute_ram_end_from_linker() {
     return addr;
 }
 
+// Probe accesses that reach the chip even through the data cache: stores
+// are written back and dropped, loads drop the line first so they miss
+constexpr bool PROBE_THROUGH_CACHE = PSRAM_UNCACHED_OFFSET == 0;
+
+static uint32_t probe_load(volatile uint32_t* p) {
+    if (PROBE_THROUGH_CACHE) Cache::writeback_invalidate(const_cast<uint32_t*>(p), sizeof(uint32_t));
+    return *p;
+}
+
+static void probe_store(volatile uint32_t* p, uint32_t value) {
+    *p = value;
+    if (PROBE_THROUGH_CACHE) Cache::writeback_invalidate(const_cast<uint32_t*>(p), sizeof(uint32_t));
+}
+
+ProbeResult probe_ram_size(uintptr_t ram_base) {
+    if (s_probe.valid) return s_probe;
+    // A cached probe never sees the alias and would report PROBE_MAX_SIZE
+    if (PROBE_THROUGH_CACHE && !Cache::available()) return ProbeResult{0, 0, false};
+
+    uint64_t start = Timer::cycles();
+    uintptr_t base = ram_base + PSRAM_UNCACHED_OFFSET;
+    volatile uint32_t* p0 = reinterpret_cast<volatile uint32_t*>(base);
+
+    uint32_t saved0 = probe_load(p0);
+    probe_store(p0, PROBE_MARKER);
+
+    std::size_t size = PROBE_MAX_SIZE;
+    uint32_t step = 1;
+    for (std::size_t s = PROBE_MIN_SIZE; s < PROBE_MAX_SIZE; s <<= 1, step++) {
+        volatile uint32_t* ps = reinterpret_cast<volatile uint32_t*>(base + s);
+        uint32_t saved = probe_load(ps);
+        probe_store(ps, PROBE_MARKER | step);
+
+        bool aliased = probe_load(p0) == (PROBE_MARKER | step);
+        bool present = probe_load(ps) == (PROBE_MARKER | step);
+        if (aliased || !present) {
+            // base + s is base again (or nothing): the chip ends at s
+            size = s;
+            break;
+        }
+        probe_store(ps, saved);
+    }
+
+    probe_store(p0, saved0);
+
+    s_probe.size = size;
+    s_probe.cycles = Timer::cycles() - start;
+    s_probe.valid = true;
+    return s_probe;
+}
+
+ProbeResult last_probe() {
+    return s_probe;
+}
+
 void set_ram_bounds(uintptr_t ram_base, std::size_t ram_size) {
     // Save explicitly provided bounds and mark as explicitly set.
     s_ram_base = ram_base;
@@ -78,9 +153,15 @@ bool reserve_all_except_first_8kb(bool zero_memory) {
             // If the user wants a different base, they should call set_ram_bounds().
             ram_size = linker_ram_end - ram_base;
         } else {
+#ifndef MICRO32_HOST
+            // No size from the linker: ask the chip itself, if it can be probed
+            ProbeResult probe = probe_ram_size(ram_base);
+            if (probe.valid) ram_size = probe.size;
+#else
             // Keep the compile-time defaults already in s_ram_base / s_ram_size
             ram_base = s_ram_base;
             ram_size = s_ram_size;
+#endif
         }
     }
 
@@ -94,7 +175,7 @@ bool reserve_all_except_first_8kb(bool zero_memory) {
     uintptr_t usable_start = ram_base + RESERVED_PREFIX;
     uintptr_t usable_end = ram_base + ram_size;
 
-    // Ensure 32-bit word alignment for zeroing loop
+    // Keep the region 32-bit word aligned
     constexpr uintptr_t ALIGN = 4;
     if (usable_start % ALIGN) {
         usable_start = (usable_start + (ALIGN - 1)) & ~(ALIGN - 1);
@@ -111,16 +192,10 @@ bool reserve_all_except_first_8kb(bool zero_memory) {
     // Record the reserved/usable region
     s_reserved_region.start = usable_start;
     s_reserved_region.end = usable_end;
+    s_carve_top = usable_end;
 
-    // Optionally zero memory in the region. Use volatile stores to avoid
-    // optimizations that might elide writes.
-    if (zero_memory) {
-        volatile uint32_t* p = reinterpret_cast<volatile uint32_t*>(usable_start);
-        volatile uint32_t* p_end = reinterpret_cast<volatile uint32_t*>(usable_end);
-        while (p < p_end) {
-            *p++ = 0u;
-        }
-    }
+    // Zeroing is deferred to the first hand-out of each block
+    s_zero_pending = zero_memory;
 
     s_reserved = true;
     return true;
@@ -130,4 +205,37 @@ Region get_reserved_region() {
     return s_reserved_region;
 }
 
+Region get_usable_region() {
+    Region r = s_reserved_region;
+    if (s_reserved) r.end = s_carve_top;
+    return r;
+}
+
+Region get_needs_zero_region() {
+    if (!s_zero_pending) return Region{0, 0};
+    return get_usable_region();
+}
+
+void set_carve_backend(CarveBackend backend) {
+    s_carve_backend = backend;
+}
+
+void* carve(std::size_t size, std::size_t align) {
+    if (s_carve_backend) return s_carve_backend(size, align);
+    if (!s_reserved || size == 0) return nullptr;
+    if (align == 0 || (align & (align - 1)) != 0) return nullptr;
+
+    uintptr_t start = s_reserved_region.start;
+    if (s_carve_top - start < size) return nullptr;
+
+    uintptr_t block = (s_carve_top - size) & ~(static_cast<uintptr_t>(align) - 1);
+    if (block < start) return nullptr;
+
+    // Everything from the block to the old top leaves the usable region now
+    if (s_zero_pending) MemFill::zero(reinterpret_cast<void*>(block), s_carve_top - block);
+
+    s_carve_top = block;
+    return reinterpret_cast<void*>(block);
+}
+
 } // namespace MemoryManager
\ No newline at end of file
@@ -7,6 +7,7 @@
 //  - compute the RAM region available at runtime (using a linker symbol if present)
 //  - reserve all memory except the first 8 KiB (so the first 8 KiB remain unreserved)
 //  - query the reserved region
+//  - carve fixed blocks (e.g. framebuffers) off the top of the usable region
 //
 // Design decisions and fallback behavior:
 //  - Preferred: If a linker symbol marking the top of RAM is provided (e.g. `__ram_end`),
@@ -18,15 +19,18 @@
 //
 //    The implementation expects a symbol named `__ram_end` (weakly referenced).
 //
-//  - Fallback: If the linker symbol is not available, the manager will use a compile-time
-//    fallback base and size. By default this header provides:
+//  - Fallback: If the linker symbol is not available, the manager probes the PSRAM size
+//    at the RAM base (see probe_ram_size()). Host builds, which have no PSRAM to probe,
+//    use a compile-time fallback base and size. By default this header provides:
 //
 //      DEFAULT_RAM_BASE = 0x3F800000  (PSRAM base fallback, change as needed)
 //      DEFAULT_RAM_SIZE = 32 * 1024*1024 (32 MiB)
 //
 //  - Reservation semantics: "Reserve" here is logical: the manager records the reserved
-//    region boundaries and optionally zeroes the memory. The header declares an API;
-//    the corresponding .cpp implements the behaviour (zeroing is optional).
+//    region boundaries. Zeroing is deferred: a zeroing request only records a
+//    "needs zero" region, and memory is cleared when it is first handed out (by carve()
+//    or, once it owns the region, the page allocator). The header declares an API;
+//    the corresponding .cpp implements the behaviour.
 //
 // Thread-safety / reentrancy: this is minimal boot-time code expected to run before
 // concurrency is enabled; no locking is provided in the header-level API.
@@ -52,14 +56,39 @@ constexpr std::size_t DEFAULT_RAM_SIZE = 32u * 1024u * 1024u; // 32 MiB fallback
 // The initial reserved prefix size (8 KiB)
 constexpr std::size_t RESERVED_PREFIX = 8u * 1024u; // 8 KiB
 
+// Size range the PSRAM probe can detect (the size of the address window)
+constexpr std::size_t PROBE_MIN_SIZE = 1u * 1024u * 1024u;  // 1 MiB
+constexpr std::size_t PROBE_MAX_SIZE = 64u * 1024u * 1024u; // 64 MiB
+
+struct ProbeResult {
+    std::size_t size; // detected RAM size in bytes
+    uint64_t cycles;  // CPU cycles the probe took
+    bool valid;       // false until a probe has run (or if it refused)
+};
+
 // Configure RAM bounds explicitly at runtime before calling reserve_all_except_first_8kb.
 // If you call this, it overrides the linker-symbol detection and the compile-time fallback.
 void set_ram_bounds(uintptr_t ram_base, std::size_t ram_size);
 
+// Detect the size of the RAM at `ram_base` with aliasing tests.
+// A chip smaller than the address window repeats every `size` bytes, so the probe
+// writes a marker at ram_base + 2^k (k from PROBE_MIN_SIZE up) and checks whether
+// it shows up at ram_base, or does not read back at all (nothing mapped there).
+// That is a handful of accesses per power of two rather than a scan. Every word
+// touched is restored. The first result is cached; later calls return it.
+// The probe must reach the chip: it goes through the uncached alias, or
+// writes back and invalidates each probed line. With neither available it
+// refuses and returns an invalid result; the defaults are used instead.
+ProbeResult probe_ram_size(uintptr_t ram_base);
+
+// Result of the last probe ({0, 0, false} if none ran)
+ProbeResult last_probe();
+
 // Compute and reserve all RAM except the first 8 KiB.
 // Parameters:
-//   zero_memory - if true, the function will zero the reserved memory region.
-//                 Zeroing can be expensive for large RAM sizes; choose accordingly.
+//   zero_memory - if true, the reserved region is recorded as "needs zero" instead of
+//                 being swept here; carve() and the page allocator zero memory lazily
+//                 as it is handed out (see get_needs_zero_region()).
 // Returns:
 //   true on success, false on failure (e.g. size too small).
 //
@@ -74,10 +103,26 @@ bool reserve_all_except_first_8kb(bool zero_memory = false);
 Region get_reserved_region();
 
 // Convenience: get usable RAM region (the memory available for allocation).
-// This returns the region that was reserved for use (the same as get_reserved_region()).
-inline Region get_usable_region() {
-    return get_reserved_region();
-}
+// This returns the reserved region minus anything handed out by carve().
+Region get_usable_region();
+
+// Part of the usable region that was reserved with zero_memory = true and has not been
+// handed out yet. Whoever hands that memory out must zero it first. {0,0} if zeroing
+// was not requested.
+Region get_needs_zero_region();
+
+// Carve a fixed, never-freed block of `size` bytes off the top of the usable
+// region (e.g. for framebuffers). `align` must be a power of two.
+// Returns nullptr if nothing is reserved yet or the region is too small.
+// The block is zeroed if it lies in the needs-zero region.
+// Until an allocator installs a carve backend (see set_carve_backend) the
+// usable region shrinks with every successful call.
+void* carve(std::size_t size, std::size_t align = 4);
+
+// Once an allocator owns the usable region it installs a backend here and
+// carve() is served by it instead of shrinking the region.
+using CarveBackend = void* (*)(std::size_t size, std::size_t align);
+void set_carve_backend(CarveBackend backend);
 
 // Utility: helper to convert pointer/size to Region (for implementations/tests)
 inline Region make_region(uintptr_t base, std::size_t size) {
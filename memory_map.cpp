@@ -0,0 +1,155 @@
+/*
+ * micro32/memory_map.cpp
+ *
+ * Region table and placement-aware allocation. See memory_map.h.
+ *
+ * Notes:
+ *  - Entry 0 mirrors MemoryManager's reserved region and is refreshed on
+ *    every call, so it follows set_ram_bounds()/reservation changes.
+ *  - The linker symbols are weak, like __ram_end in memory_manager.cpp;
+ *    a missing pair simply means the region is not registered.
+ */
+
+#include "memory_map.h"
+#include "memory_manager.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace MemoryMap {
+
+extern "C" {
+    extern char __sram_free_start[] __attribute__((weak));
+    extern char __sram_free_end[] __attribute__((weak));
+    extern char __tcm_free_start[] __attribute__((weak));
+    extern char __tcm_free_end[] __attribute__((weak));
+}
+
+constexpr uint32_t NOT_ELIGIBLE = 0xFFFFFFFFu;
+
+static Region s_regions[MAX_REGIONS];
+static int s_count = 0;
+
+// Keep entry 0 in sync with MemoryManager and register linker regions once
+static void refresh() {
+    MemoryManager::Region reserved = MemoryManager::get_reserved_region();
+    Region& psram = s_regions[0];
+    psram.name = "psram";
+    psram.kind = Kind::Psram;
+    psram.attrs = ATTR_DMA | ATTR_CACHED;
+    psram.latency = PSRAM_LATENCY;
+    psram.start = reserved.start;
+    psram.end = reserved.end;
+    psram.top = MemoryManager::get_usable_region().end;
+
+    if (s_count == 0) {
+        s_count = 1;
+        if (&__sram_free_start != nullptr && &__sram_free_end != nullptr) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(__sram_free_start);
+            uintptr_t end = reinterpret_cast<uintptr_t>(__sram_free_end);
+            if (end > start) {
+                add_region("sram", Kind::Sram, start, end - start,
+                           ATTR_DMA | ATTR_EXEC | ATTR_CACHED, SRAM_LATENCY);
+            }
+        }
+        if (&__tcm_free_start != nullptr && &__tcm_free_end != nullptr) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(__tcm_free_start);
+            uintptr_t end = reinterpret_cast<uintptr_t>(__tcm_free_end);
+            if (end > start) {
+                add_region("tcm", Kind::Tcm, start, end - start, ATTR_EXEC, TCM_LATENCY);
+            }
+        }
+    }
+}
+
+bool add_region(const char* name, Kind kind, uintptr_t start, std::size_t size,
+                uint32_t attrs, uint32_t latency) {
+    if (s_count == 0) refresh();
+    if (s_count >= MAX_REGIONS || size == 0) return false;
+
+    uintptr_t end = start + size;
+    for (int i = 0; i < s_count; i++) {
+        if (start < s_regions[i].end && s_regions[i].start < end) return false;
+    }
+
+    Region& r = s_regions[s_count++];
+    r.name = name;
+    r.kind = kind;
+    r.attrs = attrs;
+    r.latency = latency;
+    r.start = start;
+    r.end = end;
+    r.top = end;
+    return true;
+}
+
+// Search key for `r` under `placement`; lower is tried first
+static uint32_t rank(const Region& r, Placement placement) {
+    switch (placement) {
+    case Placement::Hot:
+        return r.latency;
+    case Placement::Dma:
+        return (r.attrs & ATTR_DMA) ? r.latency : NOT_ELIGIBLE;
+    case Placement::Uncached:
+        return (r.attrs & ATTR_DMA) && !(r.attrs & ATTR_CACHED) ? r.latency : NOT_ELIGIBLE;
+    case Placement::Bulk:
+        if (r.kind == Kind::Tcm) return NOT_ELIGIBLE;
+        return r.kind == Kind::Psram ? 0 : 0x7FFFFFFFu - r.latency;
+    default:
+        // Slowest first, keeping fast memory for Hot/Dma requests
+        return r.kind == Kind::Psram ? 0 : 0x7FFFFFFFu - r.latency;
+    }
+}
+
+static void* bump(Region& r, std::size_t size, std::size_t align) {
+    if (r.top - r.start < size) return nullptr;
+    uintptr_t block = (r.top - size) & ~(static_cast<uintptr_t>(align) - 1);
+    if (block < r.start) return nullptr;
+    r.top = block;
+    return reinterpret_cast<void*>(block);
+}
+
+void* alloc(std::size_t size, std::size_t align, Placement placement) {
+    if (size == 0 || align == 0 || (align & (align - 1)) != 0) return nullptr;
+    refresh();
+
+    // Try regions in rank order (the table is tiny, so select repeatedly)
+    uint32_t tried = 0;
+    for (int pass = 0; pass < s_count; pass++) {
+        int best = -1;
+        uint32_t best_rank = NOT_ELIGIBLE;
+        for (int i = 0; i < s_count; i++) {
+            if (tried & (1u << i)) continue;
+            uint32_t k = rank(s_regions[i], placement);
+            if (k < best_rank) {
+                best = i;
+                best_rank = k;
+            }
+        }
+        if (best < 0) break;
+        tried |= 1u << best;
+
+        void* block = best == 0 ? MemoryManager::carve(size, align)
+                                : bump(s_regions[best], size, align);
+        if (block != nullptr) return block;
+    }
+    return nullptr;
+}
+
+const Region* find(const void* addr) {
+    refresh();
+    uintptr_t a = reinterpret_cast<uintptr_t>(addr);
+    for (int i = 0; i < s_count; i++) {
+        if (a >= s_regions[i].start && a < s_regions[i].end) return &s_regions[i];
+    }
+    return nullptr;
+}
+
+int regions(Region* out, int max) {
+    refresh();
+    for (int i = 0; i < s_count && i < max; i++) {
+        out[i] = s_regions[i];
+    }
+    return s_count;
+}
+
+} // namespace MemoryMap
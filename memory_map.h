@@ -0,0 +1,87 @@
+#ifndef MICRO32_MEMORY_MAP_H
+#define MICRO32_MEMORY_MAP_H
+
+// memory_map.h
+// Table of the RAM regions on the board (TCM, internal SRAM, PSRAM) with
+// their attributes, and a placement-aware allocator for permanent buffers.
+//
+// Regions:
+//  - The PSRAM region MemoryManager reserved is always entry 0. Its blocks
+//    come from MemoryManager::carve(), so they are served by the page
+//    allocator once it is running.
+//  - Faster regions are registered with add_region(). Free SRAM/TCM ranges
+//    exported by the linker as weak symbols (__sram_free_start/_end,
+//    __tcm_free_start/_end) are registered automatically on first use.
+//    Such regions only hand out never-freed blocks from their top.
+//
+// Placement hints pick the search order:
+//  - Hot:  fastest first (TCM, SRAM, PSRAM), e.g. lookup tables, hot caches
+//  - Dma:  DMA-capable regions only, fastest first, e.g. descriptor rings
+//  - Bulk: PSRAM first, then SRAM; never TCM, e.g. framebuffers
+//  - Uncached: DMA-capable regions outside the data cache only, fastest
+//    first; for DMA buffers when the cache cannot be maintained (cache.h)
+//  - Any:  PSRAM first, then any other region
+//
+// Thread-safety: none; intended for init-time allocations.
+
+#include <cstdint>
+#include <cstddef>
+
+namespace MemoryMap {
+
+enum class Kind : uint8_t {
+    Tcm,
+    Sram,
+    Psram,
+};
+
+// Region attribute bits
+constexpr uint32_t ATTR_DMA = 1u << 0;     // reachable by the GDMA engines
+constexpr uint32_t ATTR_EXEC = 1u << 1;    // instruction fetch allowed
+constexpr uint32_t ATTR_CACHED = 1u << 2;  // accessed through the data cache
+
+enum class Placement : uint8_t {
+    Any,
+    Hot,
+    Dma,
+    Bulk,
+    Uncached,
+};
+
+// Rough access latencies (CPU cycles) on the ESP32-P4; pass measured values
+// to add_region() where known
+constexpr uint32_t TCM_LATENCY = 1;
+constexpr uint32_t SRAM_LATENCY = 4;
+constexpr uint32_t PSRAM_LATENCY = 40;
+
+constexpr int MAX_REGIONS = 8;
+
+struct Region {
+    const char* name;
+    Kind kind;
+    uint32_t attrs;
+    uint32_t latency;     // typical access latency in CPU cycles (lower = faster)
+    uintptr_t start;
+    uintptr_t end;        // exclusive
+    uintptr_t top;        // blocks are handed out below this address
+};
+
+// Register a region. Returns false if the table is full or the range is
+// empty or overlaps a registered region.
+bool add_region(const char* name, Kind kind, uintptr_t start, std::size_t size,
+                uint32_t attrs, uint32_t latency);
+
+// Allocate a permanent block of `size` bytes (`align` a power of two) from
+// the best region for `placement`. Returns nullptr if no suitable region
+// has room.
+void* alloc(std::size_t size, std::size_t align, Placement placement);
+
+// Region containing `addr`, or nullptr
+const Region* find(const void* addr);
+
+// Fill `out` with up to `max` regions; returns how many are registered
+int regions(Region* out, int max);
+
+} // namespace MemoryMap
+
+#endif // MICRO32_MEMORY_MAP_H
@@ -0,0 +1,82 @@
+#ifndef MICRO32_MMIO_H
+#define MICRO32_MMIO_H
+
+// mmio.h
+// Memory-mapped register access used by all drivers.
+//
+// Target builds compile these to plain volatile loads/stores. Host builds
+// (MICRO32_HOST defined) route them to a recording backend (mmio_host.cpp)
+// that keeps a software register file and counts every access, so driver
+// efficiency can be measured off-device:
+//  - every write/read is counted, in total and per register
+//  - writes to registered "data ports" (e.g. the SPI data/FIFO registers)
+//    count as bytes on the wire; DMA models add their bytes explicitly
+//  - simulated wire time is bytes * 8 / wire clock
+//
+// Reads return the last value written unless a fixed read value has been
+// set for the address (used to model status bits that never report busy).
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Mmio {
+
+#ifndef MICRO32_HOST
+
+inline void write32(uintptr_t addr, uint32_t value) {
+    *(volatile uint32_t*)addr = value;
+}
+
+inline uint32_t read32(uintptr_t addr) {
+    return *(volatile uint32_t*)addr;
+}
+
+#else
+
+void write32(uintptr_t addr, uint32_t value);
+uint32_t read32(uintptr_t addr);
+
+// Recording backend controls (host builds only)
+namespace Host {
+    struct Stats {
+        uint64_t writes;         // register writes
+        uint64_t reads;          // register reads
+        uint64_t bytes_on_wire;  // bytes sent through data ports and DMA
+        uint64_t wire_ns;        // simulated time those bytes take on the wire
+    };
+
+    // Writes to `addr` put `bytes_per_write` bytes on the wire
+    void register_data_port(uintptr_t addr, uint32_t bytes_per_write);
+
+    // Reads of `addr` always return `value`
+    void set_read_value(uintptr_t addr, uint32_t value);
+
+    // Account bytes moved by a modelled DMA engine
+    void add_wire_bytes(uint64_t bytes);
+
+    // Serial clock used for simulated wire time (default 40 MHz)
+    void set_wire_hz(uint32_t hz);
+
+    // Writes recorded for one register since the last reset
+    uint64_t writes_to(uintptr_t addr);
+
+    Stats stats();
+
+    // Clear counters (register contents and port setup are kept)
+    void reset_stats();
+}
+
+#endif
+
+// Read-modify-write helpers
+inline void set_bits(uintptr_t addr, uint32_t mask) {
+    write32(addr, read32(addr) | mask);
+}
+
+inline void clear_bits(uintptr_t addr, uint32_t mask) {
+    write32(addr, read32(addr) & ~mask);
+}
+
+} // namespace Mmio
+
+#endif // MICRO32_MMIO_H
@@ -0,0 +1,114 @@
+/*
+ * micro32/mmio_host.cpp
+ *
+ * Recording MMIO backend for host builds (MICRO32_HOST). Compiles to
+ * nothing on target builds.
+ *
+ * Behavior:
+ *  - Registers live in a fixed-size open-addressed table keyed by address;
+ *    each slot keeps the current value, an optional fixed read value, the
+ *    data-port width and a write counter.
+ *  - Writes to a data port add its width to the wire byte count.
+ *  - Running out of slots aborts: folding registers together would
+ *    silently corrupt the model. Raise MAX_REGISTERS if a driver needs more.
+ */
+
+#ifdef MICRO32_HOST
+
+#include "mmio.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Mmio {
+
+constexpr int MAX_REGISTERS = 256;  // power of two
+
+struct Slot {
+    uintptr_t addr;
+    uint32_t value;
+    uint32_t read_value;
+    uint32_t port_bytes;  // 0 = not a data port
+    bool used;
+    bool fixed_read;
+    uint64_t writes;
+};
+
+static Slot s_regs[MAX_REGISTERS];
+static Host::Stats s_stats = {};
+static uint32_t s_wire_hz = 40000000u;
+
+// Find (or create) the slot for an address
+static Slot& slot(uintptr_t addr) {
+    uint32_t i = static_cast<uint32_t>((addr >> 2) * 0x9E3779B1u) % MAX_REGISTERS;
+    for (int probes = 0; probes < MAX_REGISTERS; probes++) {
+        Slot& s = s_regs[i];
+        if (!s.used) {
+            s.used = true;
+            s.addr = addr;
+            return s;
+        }
+        if (s.addr == addr) return s;
+        i = (i + 1) % MAX_REGISTERS;
+    }
+    fprintf(stderr, "mmio_host: register table full (MAX_REGISTERS = %d) at 0x%lx\n",
+            MAX_REGISTERS, static_cast<unsigned long>(addr));
+    abort();
+}
+
+static void add_bytes(uint64_t bytes) {
+    s_stats.bytes_on_wire += bytes;
+    s_stats.wire_ns = s_stats.bytes_on_wire * 8u * 1000000000u / s_wire_hz;
+}
+
+void write32(uintptr_t addr, uint32_t value) {
+    Slot& s = slot(addr);
+    s.value = value;
+    s.writes++;
+    s_stats.writes++;
+    if (s.port_bytes) add_bytes(s.port_bytes);
+}
+
+uint32_t read32(uintptr_t addr) {
+    Slot& s = slot(addr);
+    s_stats.reads++;
+    return s.fixed_read ? s.read_value : s.value;
+}
+
+void Host::register_data_port(uintptr_t addr, uint32_t bytes_per_write) {
+    slot(addr).port_bytes = bytes_per_write;
+}
+
+void Host::set_read_value(uintptr_t addr, uint32_t value) {
+    Slot& s = slot(addr);
+    s.fixed_read = true;
+    s.read_value = value;
+}
+
+void Host::add_wire_bytes(uint64_t bytes) {
+    add_bytes(bytes);
+}
+
+void Host::set_wire_hz(uint32_t hz) {
+    if (hz) s_wire_hz = hz;
+}
+
+uint64_t Host::writes_to(uintptr_t addr) {
+    return slot(addr).writes;
+}
+
+Host::Stats Host::stats() {
+    return s_stats;
+}
+
+void Host::reset_stats() {
+    s_stats = Host::Stats();
+    for (int i = 0; i < MAX_REGISTERS; i++) {
+        s_regs[i].writes = 0;
+    }
+}
+
+} // namespace Mmio
+
+#endif // MICRO32_HOST
@@ -0,0 +1,465 @@
+/*
+ * micro32/page_allocator.cpp
+ *
+ * Binary buddy page-frame allocator. See page_allocator.h for the layout.
+ *
+ * Notes:
+ *  - Page indices are relative to the first data page (after metadata), so
+ *    the buddy of block i at order k is i ^ (1 << k).
+ *  - The per-page metadata byte is only meaningful for the first page of a
+ *    block; other pages of a block hold 0.
+ *  - A set bit in the zero bitmap means the page is zero apart from its
+ *    first sizeof(FreeBlock) bytes, which may hold a (stale) free-list node.
+ *    Handing such a page out as Zeroed only clears those bytes. Bits are
+ *    cleared whenever a page is handed out, since the owner may write it.
+ *    Only free pages ever have the bit set, so s_zero_count (set bits)
+ *    against s_free_pages gives the dirty free pages without a scan.
+ */
+
+#include "page_allocator.h"
+#include "memory_manager.h"
+#include "mem_fill.h"
+#include "mem_stats.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace PageAllocator {
+
+// Metadata byte layout
+constexpr uint8_t META_FREE = 0x80;   // first page of a free block
+constexpr uint8_t META_ALLOC = 0x40;  // first page of an allocated block
+constexpr uint8_t META_EXACT = 0x20;  // allocated by alloc_pages_exact()
+constexpr uint8_t META_ORDER = 0x1F;
+
+// Intrusive free-list node stored at the start of every free block
+struct FreeBlock {
+    FreeBlock* next;
+    FreeBlock* prev;
+};
+
+static uintptr_t s_base = 0;       // address of page index 0
+static std::size_t s_pages = 0;    // number of data pages
+static uint8_t* s_meta = nullptr;  // one byte per data page
+static uint8_t* s_zero = nullptr;  // one bit per data page: known zero
+static bool s_zero_default = false; // Fill::Default means Zeroed
+static FreeBlock* s_free[MAX_ORDER + 1];
+static uint32_t s_nonempty = 0;    // bit k set when s_free[k] is non-empty
+static std::size_t s_free_pages = 0;
+static std::size_t s_zero_count = 0; // set bits in s_zero
+
+// idle_zero() resume point: page s_zero_page of s_zero_block on list
+// s_zero_order (nullptr: the head of that list)
+static unsigned s_zero_order = 0;
+static FreeBlock* s_zero_block = nullptr;
+static std::size_t s_zero_page = 0;
+
+// reserve_range() calls made before init(), as [start, end)
+struct EarlyRange {
+    uintptr_t start;
+    uintptr_t end;
+};
+static EarlyRange s_early[MAX_EARLY_RESERVATIONS];
+static int s_early_count = 0;
+
+static inline FreeBlock* block_at(std::size_t index) {
+    return reinterpret_cast<FreeBlock*>(s_base + (index << PAGE_SHIFT));
+}
+
+static inline std::size_t index_of(const void* p) {
+    return (reinterpret_cast<uintptr_t>(p) - s_base) >> PAGE_SHIFT;
+}
+
+static inline bool is_zero(std::size_t index) {
+    return (s_zero[index >> 3] >> (index & 7)) & 1;
+}
+
+static inline void set_zero(std::size_t index, bool zero) {
+    if (is_zero(index) == zero) return;
+    uint8_t bit = static_cast<uint8_t>(1u << (index & 7));
+    if (zero) {
+        s_zero[index >> 3] |= bit;
+        s_zero_count++;
+    } else {
+        s_zero[index >> 3] &= static_cast<uint8_t>(~bit);
+        s_zero_count--;
+    }
+}
+
+// Clear a page, leaving the free-list node area to the caller
+static inline void zero_page_body(std::size_t index) {
+    uint8_t* page = reinterpret_cast<uint8_t*>(block_at(index));
+    MemFill::zero(page + sizeof(FreeBlock), PAGE_SIZE - sizeof(FreeBlock));
+}
+
+// Apply the fill policy to `count` pages being handed out at `index`
+static void prepare_pages(std::size_t index, std::size_t count, Fill fill) {
+    bool zeroed = fill == Fill::Zeroed || (fill == Fill::Default && s_zero_default);
+    for (std::size_t i = index; i < index + count; i++) {
+        if (zeroed) {
+            if (!is_zero(i)) zero_page_body(i);
+            memset(block_at(i), 0, sizeof(FreeBlock));
+        }
+        set_zero(i, false);
+    }
+}
+
+// Move the idle_zero() cursor to the head of the next list; returns true
+// when it wraps from the last list to the first
+static bool zero_cursor_next_list() {
+    s_zero_block = nullptr;
+    s_zero_page = 0;
+    if (++s_zero_order <= MAX_ORDER) return false;
+    s_zero_order = 0;
+    return true;
+}
+
+static void list_push(std::size_t index, unsigned order) {
+    FreeBlock* b = block_at(index);
+    b->prev = nullptr;
+    b->next = s_free[order];
+    if (b->next) b->next->prev = b;
+    s_free[order] = b;
+    s_nonempty |= 1u << order;
+    s_meta[index] = META_FREE | order;
+    s_free_pages += std::size_t(1) << order;
+}
+
+static void list_remove(std::size_t index, unsigned order) {
+    FreeBlock* b = block_at(index);
+    if (b == s_zero_block) {
+        // Resume with the next block rather than losing our place
+        s_zero_block = b->next;
+        s_zero_page = 0;
+        if (!s_zero_block) zero_cursor_next_list();
+    }
+    if (b->prev) b->prev->next = b->next;
+    else s_free[order] = b->next;
+    if (b->next) b->next->prev = b->prev;
+    if (s_free[order] == nullptr) s_nonempty &= ~(1u << order);
+    s_meta[index] = 0;
+    s_free_pages -= std::size_t(1) << order;
+}
+
+// Insert a block into the free lists, merging with free buddies
+static void free_block(std::size_t index, unsigned order) {
+    while (order < MAX_ORDER) {
+        std::size_t buddy = index ^ (std::size_t(1) << order);
+        if (buddy + (std::size_t(1) << order) > s_pages) break;
+        if (s_meta[buddy] != (META_FREE | order)) break;
+
+        list_remove(buddy, order);
+        if (buddy < index) index = buddy;
+        order++;
+    }
+    list_push(index, order);
+}
+
+// MemoryManager::carve() backend once the page pool owns the region
+static void* carve_pages(std::size_t size, std::size_t align) {
+    if (align > PAGE_SIZE) return nullptr;
+    return alloc_pages_exact((size + PAGE_SIZE - 1) >> PAGE_SHIFT, Fill::Default);
+}
+
+static inline uintptr_t page_align_up(uintptr_t addr) {
+    return (addr + PAGE_SIZE - 1) & ~(uintptr_t)(PAGE_SIZE - 1);
+}
+
+// True if pages [index, index + count) overlap an early reservation
+static bool early_reserved(std::size_t index, std::size_t count) {
+    uintptr_t start = s_base + (index << PAGE_SHIFT);
+    uintptr_t end = start + (count << PAGE_SHIFT);
+    for (int i = 0; i < s_early_count; i++) {
+        if (s_early[i].start < end && s_early[i].end > start) return true;
+    }
+    return false;
+}
+
+bool init(MemoryManager::Region region) {
+    uintptr_t start = page_align_up(region.start);
+    uintptr_t end = region.end & ~(uintptr_t)(PAGE_SIZE - 1);
+
+    // Lay out the metadata, moving the start past any early reservation it
+    // would overlap (the metadata is written before reserve_range runs)
+    std::size_t total, meta_pages;
+    bool moved;
+    do {
+        if (end <= start) return false;
+        total = (end - start) >> PAGE_SHIFT;
+        std::size_t meta_bytes = total + (total + 7) / 8;
+        meta_pages = (meta_bytes + PAGE_SIZE - 1) >> PAGE_SHIFT;
+        uintptr_t meta_end = start + (meta_pages << PAGE_SHIFT);
+
+        moved = false;
+        for (int i = 0; i < s_early_count; i++) {
+            if (s_early[i].start < meta_end && s_early[i].end > start) {
+                start = page_align_up(s_early[i].end);
+                moved = true;
+            }
+        }
+    } while (moved);
+    if (total <= meta_pages) return false;
+
+    s_meta = reinterpret_cast<uint8_t*>(start);
+    s_base = start + (meta_pages << PAGE_SHIFT);
+    s_pages = total - meta_pages;
+    s_zero = s_meta + s_pages;
+    memset(s_meta, 0, s_pages + (s_pages + 7) / 8);
+
+    // Pages are dirty until zeroed on demand or by idle_zero()
+    MemoryManager::Region pending = MemoryManager::get_needs_zero_region();
+    s_zero_default = pending.end > pending.start;
+
+    for (unsigned k = 0; k <= MAX_ORDER; k++) {
+        s_free[k] = nullptr;
+    }
+    s_nonempty = 0;
+    s_free_pages = 0;
+    s_zero_count = 0;
+    s_zero_order = 0;
+    s_zero_block = nullptr;
+    s_zero_page = 0;
+
+    // Cover the pages with the largest naturally aligned blocks that fit,
+    // leaving out early reservations (list nodes would be written into them)
+    std::size_t index = 0;
+    while (index < s_pages) {
+        unsigned order = MAX_ORDER;
+        while (order > 0 &&
+               ((index & ((std::size_t(1) << order) - 1)) != 0 ||
+                index + (std::size_t(1) << order) > s_pages ||
+                early_reserved(index, std::size_t(1) << order))) {
+            order--;
+        }
+        if (order == 0 && early_reserved(index, 1)) {
+            s_meta[index] = META_ALLOC | META_EXACT;
+        } else {
+            list_push(index, order);
+        }
+        index += std::size_t(1) << order;
+    }
+    s_early_count = 0;
+
+    MemoryManager::set_carve_backend(carve_pages);
+    return true;
+}
+
+// Take a 2^order block off the free lists without touching its contents
+static void* alloc_block(unsigned order) {
+    if (order > MAX_ORDER) return nullptr;
+
+    uint32_t candidates = s_nonempty & ~((1u << order) - 1);
+    if (candidates == 0) return nullptr;
+    unsigned k = static_cast<unsigned>(__builtin_ctz(candidates));
+
+    std::size_t index = index_of(s_free[k]);
+    list_remove(index, k);
+
+    // Split down, returning the upper halves to the free lists
+    while (k > order) {
+        k--;
+        list_push(index + (std::size_t(1) << k), k);
+    }
+
+    s_meta[index] = META_ALLOC | order;
+    return block_at(index);
+}
+
+// Report an allocation attempt to MemStats and pass the result through
+static inline void* account(void* block, std::size_t pages, uint64_t start) {
+#if MICRO32_MEM_STATS
+    std::size_t bytes = pages << PAGE_SHIFT;
+    if (block) MemStats::record_alloc(MemStats::SOURCE_PAGES, bytes, bytes, MemStats::now() - start);
+    else MemStats::record_failure(MemStats::SOURCE_PAGES, bytes);
+#else
+    (void)pages;
+    (void)start;
+#endif
+    return block;
+}
+
+void* alloc_pages(unsigned order, Fill fill) {
+    uint64_t start = MemStats::now();
+    void* block = alloc_block(order);
+    if (block != nullptr) prepare_pages(index_of(block), std::size_t(1) << order, fill);
+    return account(block, std::size_t(1) << order, start);
+}
+
+void free_pages(void* block) {
+    if (block == nullptr) return;
+    std::size_t index = index_of(block);
+    if (index >= s_pages) return;
+
+    uint8_t meta = s_meta[index];
+    if ((meta & META_ALLOC) == 0 || (meta & META_EXACT) != 0) return;
+
+#if MICRO32_MEM_STATS
+    MemStats::record_free(MemStats::SOURCE_PAGES, PAGE_SIZE << (meta & META_ORDER));
+#endif
+    free_block(index, meta & META_ORDER);
+}
+
+void* alloc_pages_exact(std::size_t count, Fill fill) {
+    if (count == 0) return nullptr;
+    uint64_t start = MemStats::now();
+
+    unsigned order = 0;
+    while ((std::size_t(1) << order) < count) order++;
+
+    void* block = alloc_block(order);
+    if (block == nullptr) return account(nullptr, count, start);
+
+    // Give back the tail in naturally aligned power-of-two pieces
+    std::size_t index = index_of(block);
+    std::size_t tail = index + count;
+    std::size_t end = index + (std::size_t(1) << order);
+    while (tail < end) {
+        unsigned k = 0;
+        while ((tail & (std::size_t(1) << k)) == 0 && tail + (std::size_t(2) << k) <= end) k++;
+        free_block(tail, k);
+        tail += std::size_t(1) << k;
+    }
+
+    s_meta[index] = META_ALLOC | META_EXACT | order;
+    prepare_pages(index, count, fill);
+    return account(block, count, start);
+}
+
+// Free block containing page `index`, as (head, order); false if allocated
+static bool find_free_block(std::size_t index, std::size_t& head, unsigned& order) {
+    for (unsigned k = 0; k <= MAX_ORDER; k++) {
+        std::size_t h = index & ~((std::size_t(1) << k) - 1);
+        if (s_meta[h] == (META_FREE | k)) {
+            head = h;
+            order = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Remember a reservation until init(); a full table widens the last entry
+static void remember_early(uintptr_t start, uintptr_t end) {
+    if (s_early_count < MAX_EARLY_RESERVATIONS) {
+        s_early[s_early_count++] = EarlyRange{start, end};
+        return;
+    }
+    EarlyRange& last = s_early[MAX_EARLY_RESERVATIONS - 1];
+    if (start < last.start) last.start = start;
+    if (end > last.end) last.end = end;
+}
+
+std::size_t reserve_range(uintptr_t start, std::size_t bytes) {
+    if (bytes == 0) return 0;
+    uintptr_t end = start + bytes;
+    if (end < start) end = UINTPTR_MAX;  // clamp a range running off the top
+    if (s_pages == 0) {
+        remember_early(start, end);
+        return 0;
+    }
+    uintptr_t managed_end = s_base + (s_pages << PAGE_SHIFT);
+    if (end <= s_base || start >= managed_end) return 0;
+    if (start < s_base) start = s_base;
+    if (end > managed_end) end = managed_end;
+
+    std::size_t first = index_of(reinterpret_cast<void*>(start));
+    std::size_t last = index_of(reinterpret_cast<void*>(end - 1));
+    std::size_t reserved = 0;
+
+    for (std::size_t index = first; index <= last; index++) {
+        std::size_t head;
+        unsigned order;
+        if (!find_free_block(index, head, order)) continue;
+
+        // Split the block down to the single page, freeing the other halves
+        list_remove(head, order);
+        while (order > 0) {
+            order--;
+            std::size_t half = std::size_t(1) << order;
+            if (index < head + half) {
+                list_push(head + half, order);
+            } else {
+                list_push(head, order);
+                head += half;
+            }
+        }
+
+        s_meta[index] = META_ALLOC | META_EXACT;
+        set_zero(index, false);
+        reserved++;
+    }
+    return reserved;
+}
+
+std::size_t idle_zero(std::size_t max_pages) {
+    // Nothing dirty: no walk at all, which is the common idle case
+    std::size_t dirty = s_free_pages - s_zero_count;
+    if (dirty < max_pages) max_pages = dirty;
+
+    // Resume where the last call stopped, so pages zeroed earlier are not
+    // tested again on every call. Blocks pushed behind the cursor are
+    // reached after it wraps; two wraps mean every list was seen.
+    std::size_t done = 0;
+    unsigned wraps = 0;
+    while (done < max_pages && wraps < 2) {
+        FreeBlock* b = s_zero_block ? s_zero_block : s_free[s_zero_order];
+        if (!b) {
+            if (zero_cursor_next_list()) wraps++;
+            continue;
+        }
+        s_zero_block = b;
+
+        std::size_t index = index_of(b);
+        std::size_t count = std::size_t(1) << s_zero_order;
+        std::size_t i = s_zero_page;
+        while (i < count && done < max_pages) {
+            std::size_t page = index + i;
+            // Eight known-zero pages of this block per bitmap byte
+            if ((page & 7) == 0 && i + 8 <= count && s_zero[page >> 3] == 0xFF) {
+                i += 8;
+                continue;
+            }
+            if (!is_zero(page)) {
+                zero_page_body(page);
+                // Only the head page's node is live; clear stale ones
+                if (i != 0) memset(block_at(page), 0, sizeof(FreeBlock));
+                set_zero(page, true);
+                done++;
+            }
+            i++;
+        }
+
+        if (i < count) {
+            s_zero_page = i;
+        } else if (b->next) {
+            s_zero_block = b->next;
+            s_zero_page = 0;
+        } else if (zero_cursor_next_list()) {
+            wraps++;
+        }
+    }
+    return done;
+}
+
+unsigned order_for(std::size_t bytes) {
+    std::size_t pages = (bytes + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    unsigned order = 0;
+    while ((std::size_t(1) << order) < pages) order++;
+    return order;
+}
+
+Stats stats() {
+    Stats st = {};
+    st.total_pages = s_pages;
+    st.free_pages = s_free_pages;
+    for (unsigned k = 0; k <= MAX_ORDER; k++) {
+        for (FreeBlock* b = s_free[k]; b; b = b->next) {
+            st.free_blocks[k]++;
+        }
+        if (s_free[k]) st.largest_free_order = k;
+    }
+    st.zero_pages = s_zero_count;
+    return st;
+}
+
+} // namespace PageAllocator
@@ -0,0 +1,105 @@
+#ifndef MICRO32_PAGE_ALLOCATOR_H
+#define MICRO32_PAGE_ALLOCATOR_H
+
+// page_allocator.h
+// Physical page-frame allocator (binary buddy system) over the memory
+// region reserved by MemoryManager.
+//
+// Layout:
+//  - The region is trimmed to page boundaries. Its first pages hold the
+//    metadata: one byte per page recording whether the page heads a free or
+//    allocated block and the block's order, followed by a bitmap of pages
+//    known to be zero. For 32 MiB that is 9 KiB.
+//  - Free blocks are kept on one intrusive doubly linked list per order
+//    (the list node lives in the free block itself), plus a bitmap of
+//    non-empty orders.
+//
+// Complexity: alloc_pages() finds the smallest non-empty order with one
+// bit scan and splits down, free_pages() merges with free buddies upwards;
+// both are O(MAX_ORDER), i.e. O(log n) in the region size.
+//
+// Zeroing: pages are never swept up front. Callers choose per allocation
+// whether they need zeroed memory (Fill::Zeroed) or will overwrite it anyway
+// (Fill::Dirty); only pages not already known to be zero are cleared on
+// hand-out. idle_zero() pre-clears free pages when the kernel has nothing
+// else to do, so later Zeroed allocations are free. Fill::Default follows
+// the reservation: Zeroed if MemoryManager was asked to zero memory.
+//
+// Once initialised the allocator also backs MemoryManager::carve(), so
+// fixed buffers carved later come out of the page pool instead of
+// overlapping it.
+//
+// Thread-safety: none; callers must serialise access.
+
+#include <cstdint>
+#include <cstddef>
+#include "memory_manager.h"
+
+namespace PageAllocator {
+
+constexpr std::size_t PAGE_SIZE = 4096;
+
+// Ranges remembered by reserve_range() before init()
+constexpr int MAX_EARLY_RESERVATIONS = 8;
+constexpr unsigned PAGE_SHIFT = 12;
+
+// Largest block is 2^MAX_ORDER pages (2^15 * 4 KiB = 128 MiB)
+constexpr unsigned MAX_ORDER = 15;
+
+// Content guarantee for newly allocated pages
+enum class Fill : uint8_t {
+    Default,  // Zeroed if the reservation requested zeroing, else Dirty
+    Zeroed,   // all bytes zero
+    Dirty,    // unspecified contents
+};
+
+struct Stats {
+    std::size_t total_pages;                  // pages managed (excluding metadata)
+    std::size_t free_pages;                   // pages currently free
+    std::size_t zero_pages;                   // free pages already known to be zero
+    unsigned largest_free_order;              // order of the largest free block
+    std::size_t free_blocks[MAX_ORDER + 1];   // free blocks per order
+};
+
+// Take over `region` (typically MemoryManager::get_usable_region()).
+// Ranges passed to reserve_range() beforehand are kept clear of the
+// metadata (the managed area starts past any that overlap it) and are
+// taken out of the free pool. Returns false if the region cannot hold the
+// metadata plus one page.
+bool init(MemoryManager::Region region);
+
+// Allocate 2^order contiguous pages, aligned to their size relative to the
+// start of the managed area. Returns nullptr when no block is large enough.
+void* alloc_pages(unsigned order, Fill fill = Fill::Default);
+
+// Return a block obtained from alloc_pages(); the order is looked up
+void free_pages(void* block);
+
+// Allocate exactly `count` contiguous pages; the unused tail of the
+// power-of-two block is returned to the free lists. Blocks from this call
+// cannot be freed with free_pages().
+void* alloc_pages_exact(std::size_t count, Fill fill = Fill::Default);
+
+// Permanently take the pages overlapping [start, start + bytes) out of the
+// free pool (e.g. firmware-reserved memory from the device tree). Pages
+// outside the managed area or already allocated are skipped. Returns the
+// number of pages reserved.
+//
+// Before init() nothing is written: the range is remembered (up to
+// MAX_EARLY_RESERVATIONS; further ones widen the last entry to cover both)
+// and applied by init(), which returns 0 here. Firmware ranges should be
+// reserved this way so the metadata never lands on them.
+std::size_t reserve_range(uintptr_t start, std::size_t bytes);
+
+// Zero up to `max_pages` free pages that are not known to be zero yet.
+// Returns how many pages were cleared (0 once every free page is zero).
+std::size_t idle_zero(std::size_t max_pages);
+
+// Smallest order whose block holds `bytes`
+unsigned order_for(std::size_t bytes);
+
+Stats stats();
+
+} // namespace PageAllocator
+
+#endif // MICRO32_PAGE_ALLOCATOR_H
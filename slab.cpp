@@ -0,0 +1,88 @@
+/*
+ * micro32/slab.cpp
+ *
+ * Fixed-size object caches. See slab.h for the design.
+ */
+
+#include "slab.h"
+#include "memory_manager.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace Slab {
+
+// Registry of initialised caches, most recent first
+static Cache* s_caches = nullptr;
+
+bool cache_init(Cache& cache, std::size_t object_size, std::size_t align, std::size_t capacity) {
+    if (cache.slab_start != 0) return true;
+    if (object_size == 0 || capacity == 0) return false;
+
+    // Free objects hold the list link, so they need at least a pointer
+    if (align < alignof(void*)) align = alignof(void*);
+    if (object_size < sizeof(void*)) object_size = sizeof(void*);
+    object_size = (object_size + align - 1) & ~(align - 1);
+
+    std::size_t slab_align = align > CACHE_LINE ? align : CACHE_LINE;
+    void* slab = MemoryManager::carve(object_size * capacity, slab_align);
+    if (slab == nullptr) return false;
+
+    cache.object_size = object_size;
+    cache.capacity = capacity;
+    cache.in_use = 0;
+    cache.peak = 0;
+    cache.slab_start = reinterpret_cast<uintptr_t>(slab);
+    cache.slab_end = cache.slab_start + object_size * capacity;
+    cache.bump = cache.slab_start;
+    cache.free_list = nullptr;
+
+    cache.next = s_caches;
+    s_caches = &cache;
+    return true;
+}
+
+void* cache_alloc(Cache& cache) {
+    void* object = cache.free_list;
+    if (object != nullptr) {
+        cache.free_list = *static_cast<void**>(object);
+    } else if (cache.bump < cache.slab_end) {
+        object = reinterpret_cast<void*>(cache.bump);
+        cache.bump += cache.object_size;
+    } else {
+        return nullptr;
+    }
+
+    cache.in_use++;
+    if (cache.in_use > cache.peak) cache.peak = cache.in_use;
+    return object;
+}
+
+void cache_free(Cache& cache, void* object) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(object);
+    if (addr < cache.slab_start || addr >= cache.bump) return;        // not ours / never handed out
+    if ((addr - cache.slab_start) % cache.object_size != 0) return;  // not an object start
+    // Nothing outstanding, or freed twice in a row: would corrupt in_use
+    // and put the object on the list twice
+    if (cache.in_use == 0 || object == cache.free_list) return;
+
+    *static_cast<void**>(object) = cache.free_list;
+    cache.free_list = object;
+    cache.in_use--;
+}
+
+int occupancy(Occupancy* out, int max) {
+    int count = 0;
+    for (Cache* c = s_caches; c != nullptr; c = c->next) {
+        if (count < max) {
+            out[count].name = c->name;
+            out[count].object_size = c->object_size;
+            out[count].capacity = c->capacity;
+            out[count].in_use = c->in_use;
+            out[count].peak = c->peak;
+        }
+        count++;
+    }
+    return count;
+}
+
+} // namespace Slab
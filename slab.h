@@ -0,0 +1,105 @@
+#ifndef MICRO32_SLAB_H
+#define MICRO32_SLAB_H
+
+// slab.h
+// Fixed-size object caches for frequently allocated kernel objects (display
+// commands, timers, tasks, messages) that should not go through the heap.
+//
+// Design:
+//  - Each cache owns one slab of `capacity` objects carved with
+//    MemoryManager::carve() (page allocator backed once it is running),
+//    aligned to CACHE_LINE.
+//  - Free objects form an intrusive singly linked list through their first
+//    word, so alloc/free are O(1) and objects carry no header. Objects that
+//    were never handed out are taken from a bump pointer, so creating a
+//    cache does not touch the slab.
+//  - Every initialised cache is registered for occupancy reporting.
+//
+// ObjectPool<T, N> is the typed front end: it sets the cache up on first
+// use (so pools can be plain globals, constant-initialised before the
+// memory manager runs) and constructs/destroys T in place.
+//
+// Thread-safety: none; callers must serialise access.
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace Slab {
+
+constexpr std::size_t CACHE_LINE = 64;
+
+struct Cache {
+    const char* name;
+    std::size_t object_size;  // bytes per object after rounding
+    std::size_t capacity;     // objects in the slab
+    std::size_t in_use;
+    std::size_t peak;
+    uintptr_t slab_start;     // 0 until the cache is initialised
+    uintptr_t slab_end;
+    uintptr_t bump;           // next never-used object
+    void* free_list;          // recycled objects
+    Cache* next;              // registry link
+
+    constexpr explicit Cache(const char* cache_name)
+        : name(cache_name), object_size(0), capacity(0), in_use(0), peak(0),
+          slab_start(0), slab_end(0), bump(0), free_list(nullptr), next(nullptr) {}
+};
+
+// Occupancy snapshot of one cache
+struct Occupancy {
+    const char* name;
+    std::size_t object_size;
+    std::size_t capacity;
+    std::size_t in_use;
+    std::size_t peak;
+};
+
+// Carve the slab for `cache` and register it. Returns false if no memory
+// could be carved. Calling it again on an initialised cache is a no-op.
+bool cache_init(Cache& cache, std::size_t object_size, std::size_t align, std::size_t capacity);
+
+// O(1) allocate/free; alloc returns nullptr when the cache is full.
+// free ignores pointers that are not an object this cache handed out, and
+// frees while nothing is in use, so in_use stays consistent. A double free
+// is only caught if the object is still at the head of the free list.
+void* cache_alloc(Cache& cache);
+void cache_free(Cache& cache, void* object);
+
+// Fill `out` with up to `max` registered caches; returns how many there are
+int occupancy(Occupancy* out, int max);
+
+// Typed pool of up to N objects of type T
+template <typename T, std::size_t N>
+class ObjectPool {
+public:
+    constexpr explicit ObjectPool(const char* name) : cache_(name) {}
+
+    // Allocate and construct a T; nullptr when the pool is exhausted
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (cache_.slab_start == 0 && !cache_init(cache_, sizeof(T), alignof(T), N)) {
+            return nullptr;
+        }
+        void* p = cache_alloc(cache_);
+        return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Destroy and release an object obtained from create()
+    void destroy(T* object) {
+        if (object == nullptr) return;
+        object->~T();
+        cache_free(cache_, object);
+    }
+
+    std::size_t in_use() const { return cache_.in_use; }
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    Cache cache_;
+};
+
+} // namespace Slab
+
+#endif // MICRO32_SLAB_H
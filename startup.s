@@ -1,60 +1,129 @@
 
-.equ STACK_START, 0x20002000 // 8KB of RAM for a minimal stack
-.equ HEAP_START, 0x20001000  // Start of the conceptual memory area to clear
-.equ HEAP_END, 0x20001800    // End of the conceptual memory area to clear (2KB chunk cleared)
-
-// RISC-V-specific constants
-.equ BSS_START, 0x20000800   // Start of BSS section
-.equ BSS_END, 0x20001000     // End of BSS section
-
-// BSS section boundaries (for zero-initialization)
-.equ BSS_START, 0x20000800   // Start of BSS section
-.equ BSS_END, 0x20001000     // End of BSS section
+// Memory layout comes from the linker script (micro32.ld):
+//   __stack_top                              initial stack pointer
+//   __data_load_start, __data_start/_end     .data image in flash and its place in SRAM
+//   __bss_start/_end                         .bss to clear (16-byte aligned)
+//   __init_array_start/_end                  static constructors
+//   __sram_free_start/_end                   free SRAM, cleared on a panic reboot
 
 // Exit codes for system shutdown dispatcher
 .equ EXIT_FULL_SHUTDOWN, 6046
 .equ EXIT_LOW_POWER_SLEEP, 6045
 .equ EXIT_PANIC_REBOOT, 0001
 
-.section .vectors
-.word STACK_START        // 1. Initial Stack Pointer
-.word Reset_Handler + 1  // 2. Initial Program Counter (Jump to Reset_Handler)
+// Boot log: 64-bit mcycle stamps, see boot_log.h (BootLog::MAX_ENTRIES entries)
+.equ BOOT_LOG_ENTRIES, 16
+.equ BOOT_STAGE_RESET, 0     // Reset_Handler entered
+.equ BOOT_STAGE_STACK, 1     // Stack pointer set up
+.equ BOOT_STAGE_BSS, 2       // BSS cleared
+
+// Store mcycle into boot_log_cycles[slot]; clobbers t3-t6 only (a0/a1 carry boot arguments)
+.macro BOOT_STAMP slot
+1:
+    csrr t4, mcycleh         // Read the 64-bit counter without a carry race
+    csrr t5, mcycle
+    csrr t6, mcycleh
+    bne t4, t6, 1b
+    .option push
+    .option norelax          // May run before gp is set up
+    la t3, boot_log_cycles
+    .option pop
+    sw t5, (\slot * 8)(t3)   // Low word
+    sw t4, (\slot * 8 + 4)(t3) // High word
+.endm
 
-.section .text
+// Not cleared with BSS, so stamps taken before the BSS loop survive it
+.section .noinit, "aw", @nobits
+.align 3
+.global boot_log_cycles
+boot_log_cycles:
+    .space BOOT_LOG_ENTRIES * 8
+
+.section .text.Reset_Handler, "ax", @progbits
 .global Reset_Handler
 Reset_Handler:
-    // 1. Initialize stack pointer
-    la sp, STACK_START       // Load stack pointer with STACK_START
+    BOOT_STAMP BOOT_STAGE_RESET
+
+    // 1. Initialize stack and global pointers (no gp-relative relaxation before gp is set)
+.option push
+.option norelax
+    la sp, __stack_top       // Load stack pointer with the top of the boot stack
+    la gp, __global_pointer$
+.option pop
+    BOOT_STAMP BOOT_STAGE_STACK
+
+    // 2. Copy the initialized data section from flash to SRAM (4 words per iteration)
+    la t0, __data_load_start // Source in flash
+    la t1, __data_start      // Destination in SRAM
+    la t2, __data_end
+    beq t0, t1, .data_copy_done // Already in place (image loaded into RAM)
 
-    // 2. Initialize the BSS section (Zero-fill uninitialized variables)
-    li t0, 0                 // Value to write (zero)
-    la t1, BSS_START         // Load address of BSS_START into t1
-    la t2, BSS_END           // Load address of BSS_END into t2
+.data_copy_loop:
+    bgeu t1, t2, .data_copy_done // Section end is 16-byte aligned
+    lw t3, 0(t0)
+    lw t4, 4(t0)
+    lw t5, 8(t0)
+    lw t6, 12(t0)
+    sw t3, 0(t1)
+    sw t4, 4(t1)
+    sw t5, 8(t1)
+    sw t6, 12(t1)
+    addi t0, t0, 16
+    addi t1, t1, 16
+    j .data_copy_loop
+
+.data_copy_done:
+    // 3. Zero-fill the BSS section (4 words per iteration)
+    la t1, __bss_start       // Both ends are 16-byte aligned by the linker script
+    la t2, __bss_end
 
 .bss_init_loop:
-    bge t1, t2, .bss_init_done // If t1 >= t2, we are done
-    sw t0, 0(t1)              // Store 0 into memory location pointed by t1
-    addi t1, t1, 4            // Increment address by 4 bytes
-    j .bss_init_loop          // Jump back to loop
+    bgeu t1, t2, .bss_init_done // If t1 >= t2, we are done
+    sw zero, 0(t1)           // Store 4 words of 0 per iteration
+    sw zero, 4(t1)
+    sw zero, 8(t1)
+    sw zero, 12(t1)
+    addi t1, t1, 16          // Advance by 16 bytes
+    j .bss_init_loop         // Jump back to loop
 
 .bss_init_done:
-    // 3. Jump to the C entry point (main)
-    jal main                  // Jump and link to the 'main' function
+    BOOT_STAMP BOOT_STAGE_BSS
+
+    // 4. Run static constructors; keep the boot arguments (a0/a1) in saved registers
+    mv s2, a0
+    mv s3, a1
+    la s0, __init_array_start
+    la s1, __init_array_end
+
+.init_array_loop:
+    bgeu s0, s1, .init_array_done
+    lw t0, 0(s0)             // Constructor address
+    jalr t0
+    addi s0, s0, 4
+    j .init_array_loop
+
+.init_array_done:
+    // 5. Jump to the C++ entry point with the boot arguments restored
+    mv a0, s2                // a0: hart id
+    mv a1, s3                // a1: device tree pointer (not guaranteed)
+    call kernel_main
+    li s0, 0                 // kernel_main returned: no exit code, default action
 
 // --- System Exit Dispatcher ---
 // This is reached ONLY if main() returns or system_exit() forces a jump here.
+// The exit code is in s0 (x8, the register the dispatcher has always used).
 End_Loop:
-    cmp r8, EXIT_FULL_SHUTDOWN    // Check for FULL SHUTDOWN code (6046)
-    beq .full_shutdown
+    li t0, EXIT_FULL_SHUTDOWN
+    beq s0, t0, .full_shutdown     // Check for FULL SHUTDOWN code (6046)
 
-    cmp r8, EXIT_LOW_POWER_SLEEP    // Check for LOW-POWER SLEEP code (6045)
-    beq .low_power_sleep
+    li t0, EXIT_LOW_POWER_SLEEP
+    beq s0, t0, .low_power_sleep   // Check for LOW-POWER SLEEP code (6045)
 
-    cmp r8, EXIT_PANIC_REBOOT
-    beq .clear_states // Jumps here if r8 == 1 (The Panic/Clean Reboot code)
+    li t0, EXIT_PANIC_REBOOT
+    beq s0, t0, .clear_states      // Jumps here if s0 == 1 (The Panic/Clean Reboot code)
 
-    // Default action if r8 is not 6045, 6046, or 0001: REBOOT
-    B Reset_Handler
+    // Default action if s0 is not 6045, 6046, or 0001: REBOOT
+    j Reset_Handler
 
 // --- Special Reset Routine (Kernel Panic/Clean Reboot) ---
 .clear_states:
@@ -91,17 +160,28 @@ End_Loop:
     mv a6, t0
     mv a7, t0
 
-    // Step 2: Clear Heap Memory Area
+    // Step 2: Clear the free SRAM (the area MemoryMap hands out)
     // t0 is already 0 (the value to write)
-    la t1, HEAP_START        // Load starting address into t1
-    la t2, HEAP_END          // Load end address into t2
+    la t1, __sram_free_start // Load starting address into t1
+    la t2, __sram_free_end   // Load end address into t2
+
+    addi t3, t2, -16         // Last address where a 4-word block still fits
 
 .clear_heap_loop:
-    bge t1, t2, .done_clearing // If t1 >= t2, we are done
-    sw t0, 0(t1)              // Store 0 (t0) into the memory location pointed to by t1
-    addi t1, t1, 4            // Increment address by 4 (to clear one 32-bit word)
+    bgtu t1, t3, .clear_heap_tail // Fewer than 4 words left
+    sw t0, 0(t1)              // Store 4 words of 0 (t0) per iteration
+    sw t0, 4(t1)
+    sw t0, 8(t1)
+    sw t0, 12(t1)
+    addi t1, t1, 16           // Advance by 16 bytes
     j .clear_heap_loop        // Loop back
 
+.clear_heap_tail:
+    bgeu t1, t2, .done_clearing // If t1 >= t2, we are done
+    sw t0, 0(t1)              // Clear the remaining words one at a time
+    addi t1, t1, 4
+    j .clear_heap_tail
+
 .done_clearing:
     // Step 3: Force a complete system reboot with clean state.
     j Reset_Handler
@@ -118,3 +198,93 @@ End_Loop:
     csrci mstatus, 0x8 // Disable ALL maskable interrupts
     wfi                // Wait For Interrupt (CPU goes into deep sleep)
     j .full_shutdown   // Jump to re-enter shutdown if woken
+
+// --- Trap Vectors ---
+// Vectored mode (see trap.h): exceptions enter at trap_vectors, interrupt N
+// at trap_vectors + 4*N. Interrupt stubs save only the caller-saved
+// registers; trap_dispatch is a normal C function and preserves the rest.
+
+.equ TRAP_FRAME_SIZE, 64     // ra, t0-t6, a0-a7 (16 words, keeps sp 16-byte aligned)
+
+// Frame slots: ra 0, t0-t2 4-12, t3-t6 16-28, a0-a7 32-60
+.macro TRAP_SAVE_REST        // Everything except a0/a1, which the stubs save
+    sw ra, 0(sp)
+    sw t0, 4(sp)
+    sw t1, 8(sp)
+    sw t2, 12(sp)
+    sw t3, 16(sp)
+    sw t4, 20(sp)
+    sw t5, 24(sp)
+    sw t6, 28(sp)
+    sw a2, 40(sp)
+    sw a3, 44(sp)
+    sw a4, 48(sp)
+    sw a5, 52(sp)
+    sw a6, 56(sp)
+    sw a7, 60(sp)
+.endm
+
+.macro TRAP_RESTORE_AND_RETURN
+    lw ra, 0(sp)
+    lw t0, 4(sp)
+    lw t1, 8(sp)
+    lw t2, 12(sp)
+    lw t3, 16(sp)
+    lw t4, 20(sp)
+    lw t5, 24(sp)
+    lw t6, 28(sp)
+    lw a0, 32(sp)
+    lw a1, 36(sp)
+    lw a2, 40(sp)
+    lw a3, 44(sp)
+    lw a4, 48(sp)
+    lw a5, 52(sp)
+    lw a6, 56(sp)
+    lw a7, 60(sp)
+    addi sp, sp, TRAP_FRAME_SIZE
+    mret
+.endm
+
+// Interrupt N: stamp mcycle first, then a0 = N, a1 = entry cycles
+.macro TRAP_IRQ_STUB n
+trap_irq_\n:
+    addi sp, sp, -TRAP_FRAME_SIZE
+    sw a1, 36(sp)
+    csrr a1, mcycle          // Entry stamp for the latency statistics
+    sw a0, 32(sp)
+    li a0, \n
+    j trap_irq_common
+.endm
+
+.section .text.trap_vectors, "ax", @progbits
+.align 8                     // mtvec base alignment (vectored mode)
+.global trap_vectors
+trap_vectors:
+.option push
+.option norvc                // Entries must stay 4 bytes: no c.j
+    j trap_exception_entry   // 0: synchronous exceptions
+    .irp n, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+    j trap_irq_\n
+    .endr
+.option pop
+
+    .irp n, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31
+    TRAP_IRQ_STUB \n
+    .endr
+
+trap_irq_common:
+    TRAP_SAVE_REST
+    call trap_dispatch       // trap_dispatch(irq, entry_cycles)
+    TRAP_RESTORE_AND_RETURN
+
+trap_exception_entry:
+    addi sp, sp, -TRAP_FRAME_SIZE
+    sw a0, 32(sp)
+    sw a1, 36(sp)
+    TRAP_SAVE_REST
+    csrr a0, mcause
+    csrr a1, mepc
+    csrr a2, mtval
+    call trap_exception      // Returns the pc to resume at
+    csrw mepc, a0
+    TRAP_RESTORE_AND_RETURN
@@ -0,0 +1,35 @@
+/*
+ * micro32/text_format.cpp
+ *
+ * Line formatting for diagnostic output. See text_format.h.
+ */
+
+#include "text_format.h"
+#include <cstdint>
+
+namespace TextFormat {
+
+constexpr int CAPACITY = static_cast<int>(sizeof(Line::text));
+
+void Line::clear() {
+    len = 0;
+    text[0] = '\0';
+}
+
+void Line::add(const char* s) {
+    while (*s && len < CAPACITY - 1) text[len++] = *s++;
+    text[len] = '\0';
+}
+
+void Line::add(uint64_t v) {
+    char digits[21];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n > 0 && len < CAPACITY - 1) text[len++] = digits[--n];
+    text[len] = '\0';
+}
+
+} // namespace TextFormat
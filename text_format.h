@@ -0,0 +1,28 @@
+#ifndef MICRO32_TEXT_FORMAT_H
+#define MICRO32_TEXT_FORMAT_H
+
+// text_format.h
+// Fixed-size text line for the kernel's diagnostic dumps (boot log, memory
+// statistics), built without printf.
+//
+// Text that does not fit is cut off; the line is always NUL-terminated.
+
+#include <cstdint>
+
+namespace TextFormat {
+
+struct Line {
+    char text[64];
+    int len;
+
+    // Empty the line
+    void clear();
+
+    // Append a string / an unsigned decimal number
+    void add(const char* s);
+    void add(uint64_t v);
+};
+
+} // namespace TextFormat
+
+#endif // MICRO32_TEXT_FORMAT_H
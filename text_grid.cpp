@@ -0,0 +1,112 @@
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "text_grid.h"
+#include "lcd.h"
+#include "lcd_internal.h"
+
+namespace TextGrid {
+
+    using LCDDriver::GLYPH_WIDTH;
+    using LCDDriver::GLYPH_HEIGHT;
+
+    // Desired contents and what was last sent to the display
+    static Cell s_grid[ROWS][COLS];
+    static Cell s_shadow[ROWS][COLS];
+    static bool s_shadow_valid = false;
+
+    static Stats s_stats = {};
+
+    // Line buffer for one run of changed cells
+    static uint16_t s_line[GLYPH_HEIGHT * LCDDriver::LCD_WIDTH];
+
+    static bool sameCell(const Cell& a, const Cell& b) {
+        return a.ch == b.ch && a.fg == b.fg && a.bg == b.bg;
+    }
+
+    void init(uint16_t fg, uint16_t bg) {
+        for (int row = 0; row < ROWS; row++) {
+            clearRow(row, fg, bg);
+        }
+        invalidate();
+    }
+
+    void invalidate() {
+        s_shadow_valid = false;
+    }
+
+    void clearRow(int row, uint16_t fg, uint16_t bg) {
+        if (row < 0 || row >= ROWS) return;
+        for (int col = 0; col < COLS; col++) {
+            s_grid[row][col] = Cell{' ', fg, bg};
+        }
+    }
+
+    void Print(const char* str, int col, int row, uint16_t fg, uint16_t bg) {
+        if (row < 0 || row >= ROWS) return;
+        for (; *str && col < COLS; str++, col++) {
+            if (col < 0) continue;
+            s_grid[row][col] = Cell{*str, fg, bg};
+        }
+    }
+
+    void Print(int number, int col, int row, uint16_t fg, uint16_t bg) {
+        char buffer[12];  // Buffer to hold the integer as a string
+        snprintf(buffer, sizeof(buffer), "%d", number);
+        Print(buffer, col, row, fg, bg);
+    }
+
+    // Render cells [col0, col1) of a row into the line buffer and send them
+    // through one address window
+    static void sendRun(int row, int col0, int col1) {
+        int stride = (col1 - col0) * GLYPH_WIDTH;
+        for (int col = col0; col < col1; col++) {
+            const Cell& cell = s_grid[row][col];
+            const uint16_t* tile = LCDDriver::Text::glyphTile(cell.ch, cell.fg, cell.bg);
+            uint16_t* dst = s_line + (col - col0) * GLYPH_WIDTH;
+            for (int y = 0; y < GLYPH_HEIGHT; y++) {
+                memcpy(dst + y * stride, tile + y * GLYPH_WIDTH, GLYPH_WIDTH * sizeof(uint16_t));
+            }
+            s_shadow[row][col] = cell;
+        }
+
+        int x0 = col0 * GLYPH_WIDTH;
+        int y0 = row * GLYPH_HEIGHT;
+        LCDDriver::setWindow(x0, y0, x0 + stride - 1, y0 + GLYPH_HEIGHT - 1);
+        LCDDriver::writePixels(s_line, stride * GLYPH_HEIGHT);
+
+        s_stats.cells_sent += col1 - col0;
+        s_stats.windows++;
+    }
+
+    void commit() {
+        for (int row = 0; row < ROWS; row++) {
+            int col = 0;
+            while (col < COLS) {
+                if (s_shadow_valid && sameCell(s_grid[row][col], s_shadow[row][col])) {
+                    s_stats.cells_skipped++;
+                    col++;
+                    continue;
+                }
+
+                // Extend the run over every adjacent changed cell
+                int start = col;
+                while (col < COLS && !(s_shadow_valid && sameCell(s_grid[row][col], s_shadow[row][col]))) {
+                    col++;
+                }
+                sendRun(row, start, col);
+            }
+        }
+        s_shadow_valid = true;
+    }
+
+    Stats stats() {
+        return s_stats;
+    }
+
+    void resetStats() {
+        s_stats = Stats();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TEXT_GRID_H
+#define TEXT_GRID_H
+
+#include <cstdint>
+#include "lcd.h"
+
+// Retained character grid for dashboards and status screens.
+// Print() only updates the grid in RAM; commit() compares it with a shadow
+// copy of what the panel shows and sends just the cells that changed,
+// coalescing horizontally adjacent changed cells into one window write.
+// The shadow assumes nothing else draws over the grid area; call
+// invalidate() after drawing over it (or scrolling) to force a full redraw.
+namespace TextGrid {
+    constexpr int COLS = LCDDriver::LCD_WIDTH / LCDDriver::GLYPH_WIDTH;
+    constexpr int ROWS = LCDDriver::LCD_HEIGHT / LCDDriver::GLYPH_HEIGHT;
+
+    // One text cell: character plus its colors
+    struct Cell {
+        char ch;
+        uint16_t fg;
+        uint16_t bg;
+    };
+
+    // Counters accumulated by commit()
+    struct Stats {
+        uint32_t cells_sent;     // cells retransmitted
+        uint32_t cells_skipped;  // cells unchanged since the last commit
+        uint32_t windows;        // address windows (runs of changed cells) sent
+    };
+
+    // Fill the grid with blanks; the next commit() redraws every cell
+    void init(uint16_t fg = 0xFFFF, uint16_t bg = 0x0000);
+
+    // Write a null-terminated string into the grid at col,row (clipped to the row)
+    void Print(const char* str, int col, int row, uint16_t fg, uint16_t bg = 0x0000);
+
+    // Print a signed integer into the grid at col,row
+    void Print(int number, int col, int row, uint16_t fg, uint16_t bg = 0x0000);
+
+    // Fill a whole row with blanks
+    void clearRow(int row, uint16_t fg = 0xFFFF, uint16_t bg = 0x0000);
+
+    // Forget what the display shows; the next commit() redraws every cell
+    void invalidate();
+
+    // Send every changed cell to the display
+    void commit();
+
+    Stats stats();
+    void resetStats();
+}
+
+#endif // TEXT_GRID_H
@@ -0,0 +1,95 @@
+/*
+ * micro32/timer.cpp
+ *
+ * mtime-based delays and CPU clock calibration. See timer.h.
+ *
+ * Notes:
+ *  - The mtime address is a placeholder for the CLINT of the ESP32-P4;
+ *    replace it with the actual one.
+ *  - RV32 reads the 64-bit counter as two words, re-reading the high word
+ *    to catch a carry between the two reads.
+ *  - Host builds derive mtime from the steady clock, so delays take real
+ *    time there as well.
+ */
+
+#include "timer.h"
+#include "mmio.h"
+#include <cstdint>
+
+#ifdef MICRO32_HOST
+#include <chrono>
+#endif
+
+// Define memory-mapped registers for the machine timer
+#define CLINT_BASE 0x02000000               // Replace with the actual CLINT base address
+#define CLINT_MTIME_LO_REG (CLINT_BASE + 0xBFF8)
+#define CLINT_MTIME_HI_REG (CLINT_BASE + 0xBFFC)
+
+namespace Timer {
+
+// Calibration window in mtime ticks (about 1 ms)
+constexpr uint64_t CALIBRATION_TICKS = MTIME_HZ / 1000u;
+
+static uint32_t s_cpu_hz = 0;  // 0 until calibrate() has run
+
+uint64_t mtime() {
+#ifdef MICRO32_HOST
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return static_cast<uint64_t>(ns) * (MTIME_HZ / 1000000u) / 1000u;
+#else
+    uint32_t hi, lo, hi2;
+    do {
+        hi = Mmio::read32(CLINT_MTIME_HI_REG);
+        lo = Mmio::read32(CLINT_MTIME_LO_REG);
+        hi2 = Mmio::read32(CLINT_MTIME_HI_REG);
+    } while (hi != hi2);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+
+uint32_t calibrate() {
+    // Start on a tick edge so the window is not shortened by a partial tick
+    uint64_t t0 = mtime();
+    uint64_t start_tick;
+    while ((start_tick = mtime()) == t0);
+
+    uint64_t c0 = cycles();
+    uint64_t end_tick = start_tick + CALIBRATION_TICKS;
+    uint64_t now;
+    while ((now = mtime()) < end_tick);
+    uint64_t c1 = cycles();
+
+    uint64_t hz = (c1 - c0) * MTIME_HZ / (now - start_tick);
+    // Keep at least 1 MHz so cycle/us conversions never divide by zero
+    s_cpu_hz = hz < 1000000u ? 1000000u : static_cast<uint32_t>(hz);
+    return s_cpu_hz;
+}
+
+uint32_t cpu_hz() {
+    return s_cpu_hz ? s_cpu_hz : CPU_HZ;
+}
+
+uint64_t deadline_us(uint32_t us) {
+    // Round up so the wait is never shorter than requested
+    return mtime() + (static_cast<uint64_t>(us) * MTIME_HZ + 999999u) / 1000000u;
+}
+
+bool reached(uint64_t deadline) {
+    return mtime() >= deadline;
+}
+
+void delay_us(uint32_t us) {
+    uint64_t deadline = deadline_us(us);
+    while (!reached(deadline)) {
+        // Spin; mtime keeps counting regardless of the CPU clock
+    }
+}
+
+void delay_ms(uint32_t ms) {
+    uint64_t deadline = mtime() + static_cast<uint64_t>(ms) * (MTIME_HZ / 1000u);
+    while (!reached(deadline)) {
+    }
+}
+
+} // namespace Timer
@@ -0,0 +1,82 @@
+#ifndef MICRO32_TIMER_H
+#define MICRO32_TIMER_H
+
+// timer.h
+// Cycle-accurate time base for measurements, and wall-clock delays.
+//
+// On RISC-V targets cycles() reads the 64-bit `cycle` CSR (rdcycle/rdcycleh on
+// RV32). Host builds (MICRO32_HOST) derive an equivalent count from the
+// steady clock scaled to CPU_HZ so statistics keep the same units.
+//
+// Delays and deadlines use the machine timer (`mtime`, MTIME_HZ), which runs
+// from a fixed reference clock and so does not depend on the CPU clock or
+// cache state. calibrate() measures the real CPU clock against mtime; after
+// it has run, cycles_to_us()/us_to_cycles() use the measured rate.
+
+#include <cstdint>
+
+#ifdef MICRO32_HOST
+#include <chrono>
+#endif
+
+namespace Timer {
+
+// Core clock used to convert cycles to wall time (ESP32-P4 HP core, change as needed)
+constexpr uint32_t CPU_HZ = 360000000u;
+
+// Machine timer tick rate (replace with the actual mtime clock)
+constexpr uint32_t MTIME_HZ = 16000000u;
+
+// Current machine timer value (ticks since reset)
+uint64_t mtime();
+
+// Measure CPU cycles per microsecond against mtime over about a millisecond.
+// Returns the measured CPU clock in Hz.
+uint32_t calibrate();
+
+// CPU clock in Hz: the calibrated value, or CPU_HZ before calibrate()
+uint32_t cpu_hz();
+
+// Busy-wait for at least `us` microseconds / `ms` milliseconds
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+
+// mtime value `us` microseconds from now, and whether it has passed; lets
+// callers do other work while waiting out a minimum delay
+uint64_t deadline_us(uint32_t us);
+bool reached(uint64_t deadline);
+
+// Cycles elapsed since reset
+inline uint64_t cycles() {
+#if defined(MICRO32_HOST)
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return static_cast<uint64_t>(ns) * (CPU_HZ / 1000000u) / 1000u;
+#elif __riscv_xlen == 32
+    uint32_t hi, lo, hi2;
+    do {
+        asm volatile("rdcycleh %0" : "=r"(hi));
+        asm volatile("rdcycle %0" : "=r"(lo));
+        asm volatile("rdcycleh %0" : "=r"(hi2));
+    } while (hi != hi2);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+    uint64_t c;
+    asm volatile("rdcycle %0" : "=r"(c));
+    return c;
+#endif
+}
+
+// Convert a cycle count to microseconds
+inline uint64_t cycles_to_us(uint64_t c) {
+    return c / (cpu_hz() / 1000000u);
+}
+
+// Convert microseconds to a cycle count
+inline uint64_t us_to_cycles(uint64_t us) {
+    return us * (cpu_hz() / 1000000u);
+}
+
+} // namespace Timer
+
+#endif // MICRO32_TIMER_H
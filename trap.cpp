@@ -0,0 +1,283 @@
+/*
+ * micro32/trap.cpp
+ *
+ * Interrupt dispatch, priorities and latency statistics. See trap.h.
+ *
+ * Notes:
+ *  - trap_dispatch() and trap_exception() are called from the assembly
+ *    vectors in startup.s with interrupts disabled (hardware clears
+ *    mstatus.MIE on entry).
+ *  - Each slot caches the mie bits it masks (every registered line of the
+ *    same or lower priority), so dispatch does no scanning. The masks are
+ *    rebuilt on registration with interrupts disabled.
+ *  - enable()/disable() also update s_enabled, so the mie bits a handler
+ *    masked are only restored if they are still meant to be enabled.
+ *  - Latency is measured on the low 32 bits of mcycle; differences are
+ *    correct across a wrap.
+ */
+
+#include "trap.h"
+#include <cstdint>
+
+#ifdef MICRO32_HOST
+#include "timer.h"
+#endif
+
+// The vectors in startup.s save no FP state, so no code may use FP registers
+#if !defined(MICRO32_HOST) && defined(__riscv_flen)
+#error "trap vectors do not save f0-f31/fcsr: build without the F/D extensions"
+#endif
+
+extern "C" char trap_vectors[];
+
+namespace Trap {
+
+constexpr uint32_t MSTATUS_MIE = 1u << 3;
+constexpr uint32_t MSTATUS_MPIE = 1u << 7;
+constexpr uint32_t MTVEC_VECTORED = 1u;
+
+struct Slot {
+    Handler handler;
+    void* context;
+    uint8_t priority;
+    uint32_t mask;      // mie bits cleared while this handler runs
+};
+
+static Slot s_slots[MAX_IRQS];
+static Stats s_stats[MAX_IRQS];
+static uint32_t s_enabled = 0;
+static uint32_t s_depth = 0;
+static uint32_t s_max_depth = 0;
+static uint32_t s_spurious = 0;
+static ExceptionHandler s_exception_handler = nullptr;
+
+// --- CSR access ---
+
+#ifdef MICRO32_HOST
+static uint32_t s_host_mie = 0;
+static uint32_t s_host_mstatus = 0;
+static uint32_t s_host_mepc = 0;
+
+static inline uint32_t read_mie() { return s_host_mie; }
+static inline void write_mie(uint32_t v) { s_host_mie = v; }
+static inline uint32_t read_mstatus() { return s_host_mstatus; }
+static inline void write_mstatus(uint32_t v) { s_host_mstatus = v; }
+static inline uint32_t read_mepc() { return s_host_mepc; }
+static inline void write_mepc(uint32_t v) { s_host_mepc = v; }
+static inline void set_mie_bit() { s_host_mstatus |= MSTATUS_MIE; }
+static inline void clear_mie_bit() { s_host_mstatus &= ~MSTATUS_MIE; }
+static inline uint32_t read_mcycle() { return static_cast<uint32_t>(Timer::cycles()); }
+#else
+static inline uint32_t read_mie() {
+    uint32_t v;
+    asm volatile("csrr %0, mie" : "=r"(v));
+    return v;
+}
+static inline void write_mie(uint32_t v) { asm volatile("csrw mie, %0" : : "r"(v) : "memory"); }
+static inline uint32_t read_mstatus() {
+    uint32_t v;
+    asm volatile("csrr %0, mstatus" : "=r"(v));
+    return v;
+}
+static inline void write_mstatus(uint32_t v) { asm volatile("csrw mstatus, %0" : : "r"(v) : "memory"); }
+static inline uint32_t read_mepc() {
+    uint32_t v;
+    asm volatile("csrr %0, mepc" : "=r"(v));
+    return v;
+}
+static inline void write_mepc(uint32_t v) { asm volatile("csrw mepc, %0" : : "r"(v) : "memory"); }
+static inline void set_mie_bit() { asm volatile("csrsi mstatus, 8" : : : "memory"); }
+static inline void clear_mie_bit() { asm volatile("csrci mstatus, 8" : : : "memory"); }
+static inline uint32_t read_mcycle() {
+    uint32_t v;
+    asm volatile("csrr %0, mcycle" : "=r"(v));
+    return v;
+}
+#endif
+
+uint32_t disable_interrupts() {
+    uint32_t status = read_mstatus();
+    clear_mie_bit();
+    return status & MSTATUS_MIE;
+}
+
+void restore_interrupts(uint32_t state) {
+    if (state & MSTATUS_MIE) set_mie_bit();
+}
+
+// Recompute every slot's mask after a registration change
+static void rebuild_masks() {
+    for (unsigned i = 0; i < MAX_IRQS; i++) {
+        if (!s_slots[i].handler) continue;
+        uint32_t mask = 0;
+        for (unsigned j = 0; j < MAX_IRQS; j++) {
+            if (s_slots[j].handler && s_slots[j].priority <= s_slots[i].priority) mask |= 1u << j;
+        }
+        s_slots[i].mask = mask;
+    }
+}
+
+void init() {
+#ifndef MICRO32_HOST
+    uintptr_t base = reinterpret_cast<uintptr_t>(trap_vectors);
+    asm volatile("csrw mtvec, %0" : : "r"(base | MTVEC_VECTORED) : "memory");
+#endif
+    s_enabled = 0;
+    write_mie(0);
+    set_mie_bit();
+}
+
+bool register_handler(unsigned irq, Handler handler, void* context, uint8_t priority) {
+    if (irq >= MAX_IRQS || !handler || priority > MAX_PRIORITY) return false;
+
+    uint32_t state = disable_interrupts();
+    bool ok = s_slots[irq].handler == nullptr;
+    if (ok) {
+        s_slots[irq] = Slot{handler, context, priority, 0};
+        s_stats[irq] = Stats{0, UINT32_MAX, 0, 0};
+        rebuild_masks();
+    }
+    restore_interrupts(state);
+    return ok;
+}
+
+void unregister_handler(unsigned irq) {
+    if (irq >= MAX_IRQS) return;
+
+    uint32_t state = disable_interrupts();
+    disable(irq);
+    s_slots[irq] = Slot{};
+    rebuild_masks();
+    restore_interrupts(state);
+}
+
+void enable(unsigned irq) {
+    if (irq >= MAX_IRQS) return;
+    uint32_t state = disable_interrupts();
+    s_enabled |= 1u << irq;
+    write_mie(read_mie() | (1u << irq));
+    restore_interrupts(state);
+}
+
+void disable(unsigned irq) {
+    if (irq >= MAX_IRQS) return;
+    uint32_t state = disable_interrupts();
+    s_enabled &= ~(1u << irq);
+    write_mie(read_mie() & ~(1u << irq));
+    restore_interrupts(state);
+}
+
+void set_exception_handler(ExceptionHandler handler) {
+    s_exception_handler = handler;
+}
+
+void wait_for_interrupt() {
+#ifndef MICRO32_HOST
+    asm volatile("wfi");
+#endif
+}
+
+Stats stats(unsigned irq) {
+    if (irq >= MAX_IRQS) return Stats{};
+    uint32_t state = disable_interrupts();
+    Stats st = s_stats[irq];
+    restore_interrupts(state);
+    if (st.count == 0) st.min_cycles = 0;
+    return st;
+}
+
+uint32_t max_depth() {
+    return s_max_depth;
+}
+
+uint32_t spurious() {
+    return s_spurious;
+}
+
+} // namespace Trap
+
+using namespace Trap;
+
+// Called by the interrupt vectors with `entry_cycles` = mcycle at entry
+extern "C" void trap_dispatch(uint32_t irq, uint32_t entry_cycles) {
+    const Slot& slot = s_slots[irq];
+    if (!slot.handler) {
+        // Nobody to acknowledge it: mask the line so it cannot storm
+        s_spurious++;
+        s_enabled &= ~(1u << irq);
+        write_mie(read_mie() & ~(1u << irq));
+        return;
+    }
+
+    // A nested trap overwrites these, so keep them for our own mret
+    uint32_t saved_epc = read_mepc();
+    uint32_t saved_status = read_mstatus();
+    uint32_t saved_mie = read_mie();
+    uint32_t mask = slot.mask;
+    Handler handler = slot.handler;
+    void* context = slot.context;
+
+    write_mie(saved_mie & ~mask);
+    if (++s_depth > s_max_depth) s_max_depth = s_depth;
+
+    Stats& st = s_stats[irq];
+    uint32_t latency = read_mcycle() - entry_cycles;
+    st.count++;
+    st.total_cycles += latency;
+    if (latency < st.min_cycles) st.min_cycles = latency;
+    if (latency > st.max_cycles) st.max_cycles = latency;
+
+    // Let higher priorities preempt the handler
+    set_mie_bit();
+    handler(context);
+    clear_mie_bit();
+
+    s_depth--;
+    write_mie(read_mie() | (saved_mie & mask & s_enabled));
+    write_mepc(saved_epc);
+    write_mstatus(saved_status);
+}
+
+// Called by vector 0 for synchronous exceptions; returns the pc to resume at
+extern "C" uint32_t trap_exception(uint32_t cause, uint32_t epc, uint32_t tval) {
+    if (s_exception_handler && s_exception_handler(cause, &epc, tval)) return epc;
+
+    // Unhandled: nothing sensible to return to
+    while (true) {
+        wait_for_interrupt();
+    }
+}
+
+#ifdef MICRO32_HOST
+namespace Trap {
+namespace Mock {
+
+bool raise(unsigned irq) {
+    if (irq >= MAX_IRQS) return false;
+    if (!(read_mstatus() & MSTATUS_MIE) || !(read_mie() & (1u << irq))) return false;
+
+    // What the hardware does on entry: mepc = interrupted pc, MPIE = MIE,
+    // MIE = 0
+    uint32_t entry = read_mcycle();
+    uint32_t status = read_mstatus();
+    write_mepc(epc_for(irq));
+    write_mstatus((status & ~MSTATUS_MIE) | MSTATUS_MPIE);
+    trap_dispatch(irq, entry);
+
+    // mret: MIE = MPIE, MPIE = 1, from whatever mstatus the dispatcher left
+    status = read_mstatus();
+    write_mstatus(((status & MSTATUS_MPIE) ? (status | MSTATUS_MIE) : (status & ~MSTATUS_MIE)) | MSTATUS_MPIE);
+    return true;
+}
+
+uint32_t mepc() {
+    return read_mepc();
+}
+
+uint32_t mstatus() {
+    return read_mstatus();
+}
+
+} // namespace Mock
+} // namespace Trap
+#endif
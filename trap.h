@@ -0,0 +1,110 @@
+#ifndef MICRO32_TRAP_H
+#define MICRO32_TRAP_H
+
+// trap.h
+// Machine-mode traps: vectored interrupt dispatch and exceptions.
+//
+// Design:
+//  - init() points mtvec at trap_vectors (startup.s) in vectored mode, so
+//    interrupt N enters at base + 4*N and the cause needs no decoding.
+//  - Each vector saves only the caller-saved integer registers (ra, t0-t6,
+//    a0-a7) on the current stack, stamps mcycle and calls the C++
+//    dispatcher with the interrupt number. Handlers are plain functions, so
+//    the compiler saves any callee-saved register they use. FP registers
+//    and fcsr are not saved: the kernel must be built for an ISA without
+//    F/D (trap.cpp refuses to compile otherwise).
+//  - The allocators are not interrupt-safe. Code that shares them with
+//    handlers must call them between disable_interrupts() and
+//    restore_interrupts().
+//  - Handlers are registered per interrupt with a priority. While one runs,
+//    interrupts of the same or lower priority are masked in mie and
+//    mstatus.MIE is set again, so only higher priorities can preempt it.
+//    mepc/mstatus are kept by the dispatcher across the nested section.
+//  - The dispatcher records the entry-to-handler latency (cycles from the
+//    first vector instruction to the handler call) for every interrupt.
+//  - Synchronous exceptions enter through vector 0 and go to the exception
+//    handler, which may resume execution; the default one halts.
+//
+// Host builds (MICRO32_HOST) keep the CSRs in variables; Mock::raise()
+// delivers an interrupt synchronously through the same dispatcher.
+
+#include <cstdint>
+
+namespace Trap {
+
+// Number of mie/mip interrupt lines (vector table entries)
+constexpr unsigned MAX_IRQS = 32;
+
+// Standard machine-level interrupt numbers; 16 and up are platform lines
+constexpr unsigned IRQ_SOFTWARE = 3;
+constexpr unsigned IRQ_TIMER = 7;
+constexpr unsigned IRQ_EXTERNAL = 11;
+constexpr unsigned IRQ_PLATFORM = 16;
+
+// Handler priorities: a higher value preempts a lower one
+constexpr uint8_t MAX_PRIORITY = 7;
+
+using Handler = void (*)(void* context);
+
+// Return true to resume at `*epc` (which the handler may advance); false
+// halts the hart
+using ExceptionHandler = bool (*)(uint32_t cause, uint32_t* epc, uint32_t tval);
+
+struct Stats {
+    uint32_t count;          // handler invocations
+    uint32_t min_cycles;     // entry-to-handler latency
+    uint32_t max_cycles;
+    uint64_t total_cycles;   // divide by count for the mean
+};
+
+// Install the vector table and enable interrupts globally (every line
+// stays masked until enable())
+void init();
+
+// Attach `handler` to `irq`. Fails if the line is out of range or taken,
+// or the priority is above MAX_PRIORITY. Does not enable the line.
+bool register_handler(unsigned irq, Handler handler, void* context, uint8_t priority);
+
+// Mask the line and detach its handler
+void unregister_handler(unsigned irq);
+
+// Unmask / mask one interrupt line in mie
+void enable(unsigned irq);
+void disable(unsigned irq);
+
+// Replace the exception handler (nullptr restores the halting default)
+void set_exception_handler(ExceptionHandler handler);
+
+// Critical sections: clear mstatus.MIE and return the previous state
+uint32_t disable_interrupts();
+void restore_interrupts(uint32_t state);
+
+// Sleep until an enabled interrupt is pending
+void wait_for_interrupt();
+
+// Latency figures of one line (zeroed if out of range)
+Stats stats(unsigned irq);
+
+// Deepest nesting seen, and interrupts that arrived without a handler
+uint32_t max_depth();
+uint32_t spurious();
+
+#ifdef MICRO32_HOST
+namespace Mock {
+    // Take interrupt `irq` now if it is enabled and not masked; returns
+    // whether it was delivered. May be called from a handler to nest.
+    // Entry sets mepc to epc_for(irq), as if that irq interrupted it.
+    bool raise(unsigned irq);
+
+    // The mepc value raise(irq) writes on entry
+    constexpr uint32_t epc_for(unsigned irq) { return 0x40000000u + irq * 4u; }
+
+    // Current mepc / mstatus, as mret would see them
+    uint32_t mepc();
+    uint32_t mstatus();
+}
+#endif
+
+} // namespace Trap
+
+#endif // MICRO32_TRAP_H